@@ -0,0 +1,182 @@
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <coroutine>
+#include <unistd.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "yolo_detect.hpp"
+#include "letterbox.hpp"
+#include "histogram.hpp"
+
+
+std::string modelPath;
+std::string imagePath;
+int cameras = 4;
+int contexts = 3;
+int frames = 100;
+
+
+/* 单线程事件循环，所有相机协程都在该线程上恢复执行 */
+class EventLoop
+{
+public:
+    void Post(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push_back(std::move(task));
+        }
+        _cond.notify_one();
+    }
+
+    AsyncResult<YoloDetect::ResultPtr>::Executor GetExecutor()
+    {
+        return [this](std::function<void()> task) { Post(std::move(task)); };
+    }
+
+    /* 执行任务直到没有活跃的协程 */
+    void Run(const int& active)
+    {
+        while (active > 0) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cond.wait(lock, [this]() { return !_tasks.empty(); });
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+private:
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+};
+
+
+/* 即发即弃的协程，启动后立即执行到第一个挂起点 */
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+
+/* 每路相机一个协程，推理期间不占用事件循环线程 */
+Detached Camera(int id, YoloDetect& model, const cv::Mat& input, EventLoop& loop, int& active, Histogram& latency, size_t& objects)
+{
+    for (int i = 0; i < frames; i++) {
+        auto t1 = std::chrono::steady_clock::now();
+        auto result = co_await model.PredictAsync(input.data, input.total() * input.elemSize()).Via(loop.GetExecutor());
+        auto t2 = std::chrono::steady_clock::now();
+        latency.Add(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+        if (result) {
+            objects += result->size();
+        }
+    }
+    std::printf("camera %d finished\r\n", id);
+    active--;
+}
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 3) {
+        std::printf("Usage: %s <model> <image> [-c cameras] [-j contexts] [-f frames]\r\n", argv[0]);
+        return -1;
+    }
+
+    modelPath.assign(argv[1]);
+    imagePath.assign(argv[2]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "c:j:f:")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 相机路数 */
+            case 'c':
+                cameras = std::max(std::atoi(optarg), 1);
+                break;
+
+            /* 推理上下文数 */
+            case 'j':
+                contexts = std::max(std::atoi(optarg), 1);
+                break;
+
+            /* 每路帧数 */
+            case 'f':
+                frames = std::atoi(optarg);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* 加载模型 */
+    std::vector<std::unique_ptr<YoloDetect>> models;
+    for (int i = 0; i < contexts; i++) {
+        models.push_back(std::make_unique<YoloDetect>(modelPath));
+    }
+
+    /* 加载图片，所有相机共用同一帧 */
+    cv::Mat img = cv::imread(imagePath);
+    if (img.empty()) {
+        std::printf("read image %s failed\r\n", imagePath.c_str());
+        return -1;
+    }
+    cv::Mat input;
+    Letterbox(img, models[0]->GetInputSize(), input);
+    cv::cvtColor(input, input, cv::COLOR_BGR2RGB);
+
+    /* 阻塞用法，与同步接口等价 */
+    auto first = models[0]->PredictAsync(input.data, input.total() * input.elemSize()).Get();
+    std::printf("warmup: %ld objects\r\n", first ? first->size() : 0);
+
+    /* 所有相机协程由同一个线程驱动，按路数轮流分配上下文 */
+    EventLoop loop;
+    int active = cameras;
+    std::vector<Histogram> latency(cameras);
+    std::vector<size_t> objects(cameras, 0);
+    auto t1 = std::chrono::steady_clock::now();
+    loop.Post([&]() {
+        for (int i = 0; i < cameras; i++) {
+            Camera(i, *models[i % contexts], input, loop, active, latency[i], objects[i]);
+        }
+    });
+    loop.Run(active);
+    auto t2 = std::chrono::steady_clock::now();
+
+    double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / 1e6;
+    Histogram total;
+    for (int i = 0; i < cameras; i++) {
+        total.Merge(latency[i]);
+    }
+    std::printf("\r\n----- %d cameras, %d contexts, %d frames each, %.1f fps total -----\r\n",
+                cameras,
+                contexts,
+                frames,
+                elapsed > 0 ? cameras * frames / elapsed : 0.);
+    total.Dump("request latency");
+
+    return 0;
+}
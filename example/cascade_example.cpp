@@ -0,0 +1,174 @@
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <sstream>
+#include <chrono>
+#include <unistd.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "yolo_detect.hpp"
+#include "classify.hpp"
+#include "cascade.hpp"
+#include "label.hpp"
+#include "letterbox.hpp"
+#include "histogram.hpp"
+
+
+std::string detectPath;
+std::string classifyPath;
+std::string imagePath;
+Label detectLabel;
+Label classifyLabel;
+Cascade::Config config;
+float scoreThres = 0.25f;
+int iterations = 1;
+bool naive = false;
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 4) {
+        std::printf("Usage: %s <detect model> <classify model> <image> [-l detect label] [-L classify label] "
+                    "[-c class,...] [-j contexts] [-k topk] [-e expand] [-s scoreThres] [-i iterations] [-n]\r\n", argv[0]);
+        return -1;
+    }
+
+    detectPath.assign(argv[1]);
+    classifyPath.assign(argv[2]);
+    imagePath.assign(argv[3]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "l:L:c:j:k:e:s:i:n")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 检测类别标签 */
+            case 'l':
+                detectLabel.Load(optarg);
+                break;
+
+            /* 分类类别标签 */
+            case 'L':
+                classifyLabel.Load(optarg);
+                break;
+
+            /* 参与级联的检测类别 */
+            case 'c': {
+                std::istringstream iss(optarg);
+                std::string item;
+                while (std::getline(iss, item, ',')) {
+                    config.classes.push_back(std::atoi(item.c_str()));
+                }
+                break;
+            }
+
+            /* 分类上下文数 */
+            case 'j':
+                config.contexts = std::atoi(optarg);
+                break;
+
+            /* 每个检测框保留的分类结果数 */
+            case 'k':
+                config.topk = std::atoi(optarg);
+                break;
+
+            /* 检测框外扩比例 */
+            case 'e':
+                config.expand = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* 检测分数阈值 */
+            case 's':
+                scoreThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* 迭代次数 */
+            case 'i':
+                iterations = std::max(std::atoi(optarg), 1);
+                break;
+
+            /* 对照组：逐个检测框单独缩放并调用Classify::Predict */
+            case 'n':
+                naive = true;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* 加载模型 */
+    YoloDetect detector(detectPath, scoreThres);
+    Cascade cascade(classifyPath, config);
+    std::unique_ptr<Classify> classifier;
+    if (naive) {
+        classifier = std::make_unique<Classify>(classifyPath, config.topk);
+    }
+
+    /* 加载图片并按检测模型输入等比缩放 */
+    cv::Mat img = cv::imread(imagePath);
+    if (img.empty()) {
+        std::printf("read image %s failed\r\n", imagePath.c_str());
+        return -1;
+    }
+    Size inputSize = detector.GetInputSize();
+    Transformation trans({img.cols, img.rows}, inputSize);
+    cv::Mat input;
+    Letterbox(img, inputSize, input);
+    cv::cvtColor(input, input, cv::COLOR_BGR2RGB);
+
+    DetectionBuffer detections;
+    std::vector<Cascade::Item> items;
+    Histogram naiveLatency;
+    cv::Mat crop;
+    ClassBuffer labels;
+    for (int i = 0; i < iterations; i++) {
+        /* 检测结果映射回原图坐标后级联分类 */
+        detector.Predict(input.data, input.total() * input.elemSize(), detections, &trans);
+        cascade.Run(img.data, {img.cols, img.rows}, img.step, detections, items);
+
+        if (naive) {
+            auto t1 = std::chrono::steady_clock::now();
+            Size clsSize = classifier->GetInputSize();
+            for (auto &&det : detections) {
+                int x0 = std::max(0, static_cast<int>(det.box.x));
+                int y0 = std::max(0, static_cast<int>(det.box.y));
+                int x1 = std::min(img.cols, static_cast<int>(det.box.x + det.box.width));
+                int y1 = std::min(img.rows, static_cast<int>(det.box.y + det.box.height));
+                if (x1 <= x0 || y1 <= y0) {
+                    continue;
+                }
+                cv::resize(img(cv::Rect(x0, y0, x1 - x0, y1 - y0)), crop, cv::Size(clsSize.width, clsSize.height));
+                cv::cvtColor(crop, crop, cv::COLOR_BGR2RGB);
+                classifier->Predict(crop.data, crop.total() * crop.elemSize(), labels);
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            naiveLatency.Add(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+        }
+    }
+
+    std::printf("\r\n----- Got %ld objects -----\r\n", items.size());
+    for (auto &&item : items) {
+        const Detection &det = item.detection;
+        std::printf("%s [%.2f, %.2f, %.2f, %.2f] @ %.2f",
+                    detectLabel[det.id].c_str(),
+                    det.box.x,
+                    det.box.y,
+                    det.box.width,
+                    det.box.height,
+                    det.score);
+        for (size_t k = 0; k < item.labels.Size(); k++) {
+            std::printf("%s %s @ %.2f", k == 0 ? " ->" : ",", classifyLabel[item.labels[k].index].c_str(), item.labels[k].score);
+        }
+        std::printf("\r\n");
+    }
+
+    cascade.Dump();
+    if (naive) {
+        naiveLatency.Dump("naive per-frame latency");
+    }
+
+    return 0;
+}
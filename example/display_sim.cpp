@@ -0,0 +1,102 @@
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+#include "display_sink.hpp"
+
+
+int width = 320;
+int height = 240;
+int frames = 3;
+int rate = 60;
+int fps = 90;
+int duration = 5;
+std::string outputPath;
+
+
+/* 以空后端或文件后端驱动预览输出，只依赖显示输出及直方图，可在无目标板的环境构建运行 */
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "W:H:n:r:f:d:o:h")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 帧尺寸，RGBA8888 */
+            case 'W':
+                width = std::atoi(optarg);
+                break;
+
+            case 'H':
+                height = std::atoi(optarg);
+                break;
+
+            /* 帧缓冲数 */
+            case 'n':
+                frames = std::atoi(optarg);
+                break;
+
+            /* 呈现节拍(Hz) */
+            case 'r':
+                rate = std::atoi(optarg);
+                break;
+
+            /* 提交帧率，高于呈现节拍时多余的帧被丢弃 */
+            case 'f':
+                fps = std::atoi(optarg);
+                break;
+
+            /* 运行时长(s) */
+            case 'd':
+                duration = std::atoi(optarg);
+                break;
+
+            /* 呈现的帧追加写入该文件，未指定时使用空后端 */
+            case 'o':
+                outputPath.assign(optarg);
+                break;
+
+            default:
+                std::printf("Usage: %s [-W width] [-H height] [-n frames] [-r rate] [-f fps] [-d duration] [-o file]\r\n", argv[0]);
+                return -1;
+        }
+    }
+
+    size_t frameSize = static_cast<size_t>(width) * height * 4;
+    std::unique_ptr<DisplaySink::Backend> backend;
+    if (outputPath.empty()) {
+        backend = std::make_unique<NullDisplay>(frames, frameSize);
+    } else {
+        backend = std::make_unique<FileDisplay>(outputPath, frames, frameSize);
+    }
+    DisplaySink sink(*backend, rate);
+
+    /* 按提交帧率写入帧号作为画面内容，没有空闲帧时本次跳过 */
+    uint64_t busy = 0;
+    auto end = DisplaySink::Clock::now() + std::chrono::seconds(duration);
+    auto next = DisplaySink::Clock::now();
+    for (uint32_t n = 0; DisplaySink::Clock::now() < end; n++) {
+        int frame = sink.Acquire();
+        if (frame < 0) {
+            busy++;
+        } else {
+            std::memset(sink.GetBuffer(frame), n & 0xff, frameSize);
+            sink.Submit(frame);
+        }
+        next += std::chrono::microseconds(static_cast<int64_t>(1e6 / fps));
+        std::this_thread::sleep_until(next);
+    }
+    sink.Stop();
+
+    auto stats = sink.GetStats();
+    std::printf("submitted: %lu, shown: %lu, dropped: %lu, no free frame: %lu\r\n",
+                stats.submitted, stats.shown, stats.dropped, busy);
+    stats.latency.Dump("present latency");
+
+    return 0;
+}
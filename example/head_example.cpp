@@ -0,0 +1,162 @@
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <unistd.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "head.hpp"
+#include "classify.hpp"
+#include "yolo_detect.hpp"
+#include "label.hpp"
+#include "soak_monitor.hpp"
+
+
+std::string modelPath;
+std::string imagePath;
+Label label;
+ClassifyHead::Params params;
+int contexts = 3;
+int requests = 300;
+int64_t soakDuration = 0;
+std::string detectPath;
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 3) {
+        std::printf("Usage: %s <model> <image> [-l label] [-k topk] [-j contexts] [-n requests] [-d soakSeconds] [-y detectModel]\r\n", argv[0]);
+        return -1;
+    }
+
+    modelPath.assign(argv[1]);
+    imagePath.assign(argv[2]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "l:k:j:n:d:y:")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 类别标签 */
+            case 'l':
+                label.Load(optarg);
+                break;
+
+            /* 保留的结果数 */
+            case 'k':
+                params.topk = std::atoi(optarg);
+                break;
+
+            /* 上下文数 */
+            case 'j':
+                contexts = std::atoi(optarg);
+                break;
+
+            /* 请求数 */
+            case 'n':
+                requests = std::atoi(optarg);
+                break;
+
+            /* 浸泡时长(s)，持续异步请求并检查内存增长及延迟漂移 */
+            case 'd':
+                soakDuration = std::atol(optarg);
+                break;
+
+            /* 检测模型，以YoloHead挂接到上下文池 */
+            case 'y':
+                detectPath.assign(optarg);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* 加载图片 */
+    PredictorPool<ClassifyHead> pool(modelPath, contexts, params);
+    Size inputSize = pool[0].GetEngine().GetInputSize();
+    cv::Mat img = cv::imread(imagePath);
+    if (img.empty()) {
+        std::printf("read image %s failed\r\n", imagePath.c_str());
+        return -1;
+    }
+    cv::Mat input;
+    cv::resize(img, input, cv::Size(inputSize.width, inputSize.height));
+    cv::cvtColor(input, input, cv::COLOR_BGR2RGB);
+    size_t len = input.total() * input.elemSize();
+
+    /* 同一解码头也可挂接到单独的引擎上 */
+    Engine engine(modelPath);
+    Predictor<ClassifyHead> single(engine, params);
+    auto result = single.Predict(input.data, len);
+    std::printf("\r\n----- top %ld -----\r\n", result.Size());
+    for (size_t i = 0; i < result.Size(); i++) {
+        std::printf("%s @ %.2f\r\n", label[result[i].index].c_str(), result[i].score);
+    }
+
+    /* 异步请求轮流分配到各上下文，流水执行 */
+    std::vector<AsyncResult<ClassBuffer>> pending;
+    pending.reserve(requests);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; i++) {
+        pending.push_back(pool.PredictAsync(input.data, len));
+    }
+    for (auto &&p : pending) {
+        p.Wait();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / 1e6;
+    std::printf("\r\n%d requests, %.1f fps\r\n", requests, elapsed > 0 ? requests / elapsed : 0.);
+    pool.Dump("classify pool");
+
+    /* 检测解码头同样可挂接到上下文池，同步与异步请求经由同一上下文的执行线程串行 */
+    if (!detectPath.empty()) {
+        PredictorPool<YoloHead> detectPool(detectPath, contexts, YoloHead::Params{});
+        Size detectSize = detectPool[0].GetEngine().GetInputSize();
+        cv::Mat detectInput;
+        cv::resize(img, detectInput, cv::Size(detectSize.width, detectSize.height));
+        cv::cvtColor(detectInput, detectInput, cv::COLOR_BGR2RGB);
+        size_t detectLen = detectInput.total() * detectInput.elemSize();
+        auto async = detectPool.PredictAsync(detectInput.data, detectLen);
+        auto detections = detectPool.Predict(detectInput.data, detectLen);
+        async.Wait();
+        std::printf("\r\n----- Got %ld objects -----\r\n", detections.Size());
+        for (auto &&detection : detections) {
+            std::printf("%d [%.2f, %.2f, %.2f, %.2f] @ %.2f\r\n",
+                        detection.id,
+                        detection.box.x,
+                        detection.box.y,
+                        detection.box.width,
+                        detection.box.height,
+                        detection.score);
+        }
+        detectPool.Dump("detect pool");
+    }
+
+    /* 浸泡：保持每个上下文两个在途请求，按完成顺序记录延迟 */
+    if (soakDuration > 0) {
+        SoakMonitor monitor;
+        auto end = SoakMonitor::Clock::now() + std::chrono::seconds(soakDuration);
+        std::vector<std::pair<SoakMonitor::Clock::time_point, AsyncResult<ClassBuffer>>> inflight;
+        while (SoakMonitor::Clock::now() < end && !monitor.Failed()) {
+            while (inflight.size() < pool.GetSize() * 2) {
+                inflight.emplace_back(SoakMonitor::Clock::now(), pool.PredictAsync(input.data, len));
+            }
+            inflight.front().second.Wait();
+            auto done = SoakMonitor::Clock::now();
+            monitor.Add(std::chrono::duration_cast<std::chrono::microseconds>(done - inflight.front().first).count());
+            inflight.erase(inflight.begin());
+        }
+        for (auto &&p : inflight) {
+            p.second.Wait();
+        }
+        monitor.Sample();
+        monitor.Dump();
+        return monitor.Failed() ? 1 : 0;
+    }
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "infer_protocol.hpp"
+#include "histogram.hpp"
+
+
+std::string socketPath;
+std::string modelName;
+std::string imagePath;
+int connections = 4;
+int requests = 1000;
+int depth = 2;
+bool verbose = false;
+
+
+/* 单个连接保持depth个请求在途，记录往返延迟 */
+static void Run(int index, const std::vector<uint8_t>& image, Histogram& rtt, uint64_t& failed, std::mutex& mutex)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::printf("connect %s failed\r\n", socketPath.c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    InferProtocol::Request header {};
+    header.magic = InferProtocol::requestMagic;
+    std::strncpy(header.model, modelName.c_str(), InferProtocol::modelNameSize - 1);
+    header.format = InferProtocol::Encoded;
+    header.length = image.size();
+
+    Histogram local;
+    uint64_t localFailed = 0;
+    std::vector<std::chrono::steady_clock::time_point> sent(requests);  // 按请求id记录发送时间
+    std::vector<uint8_t> records;
+    int issued = 0;
+    int received = 0;
+    while (received < requests) {
+        /* 补足在途请求 */
+        while (issued < requests && issued - received < depth) {
+            header.id = issued;
+            sent[issued++] = std::chrono::steady_clock::now();
+            if (!InferProtocol::WriteAll(fd, &header, sizeof(header)) ||
+                !InferProtocol::WriteAll(fd, image.data(), image.size())) {
+                std::printf("connection %d send failed\r\n", index);
+                close(fd);
+                return;
+            }
+        }
+
+        /* 多上下文并行时应答可能乱序，按id匹配发送时间 */
+        InferProtocol::Response response;
+        if (!InferProtocol::ReadAll(fd, &response, sizeof(response)) || response.magic != InferProtocol::responseMagic) {
+            std::printf("connection %d receive failed\r\n", index);
+            break;
+        }
+        size_t size = response.kind == InferProtocol::Detect ?
+                      sizeof(InferProtocol::DetectRecord) :
+                      sizeof(InferProtocol::ClassRecord);
+        records.resize(response.count * size);
+        if (!InferProtocol::ReadAll(fd, records.data(), records.size())) {
+            break;
+        }
+
+        if (response.id < sent.size()) {
+            local.Add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sent[response.id]).count());
+        }
+        received++;
+        if (response.status != InferProtocol::Ok) {
+            localFailed++;
+        } else if (verbose && index == 0 && received == 1) {
+            std::printf("request %u: %u results, server latency %u us\r\n", response.id, response.count, response.latency);
+        }
+    }
+    close(fd);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    rtt.Merge(local);
+    failed += localFailed;
+}
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 4) {
+        std::printf("Usage: %s <socket> <model> <image> [-c connections] [-n requests] [-p depth] [-v]\r\n", argv[0]);
+        return -1;
+    }
+
+    socketPath.assign(argv[1]);
+    modelName.assign(argv[2]);
+    imagePath.assign(argv[3]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "c:n:p:v")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 并发连接数 */
+            case 'c':
+                connections = std::atoi(optarg);
+                break;
+
+            /* 每个连接的请求数 */
+            case 'n':
+                requests = std::atoi(optarg);
+                break;
+
+            /* 每个连接的在途请求数 */
+            case 'p':
+                depth = std::max(1, std::atoi(optarg));
+                break;
+
+            /* 打印首个结果 */
+            case 'v':
+                verbose = true;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* 编码图像原样发送，由服务端解码 */
+    std::ifstream file(imagePath, std::ios::binary);
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (image.empty()) {
+        std::printf("read image %s failed\r\n", imagePath.c_str());
+        return -1;
+    }
+
+    Histogram rtt;
+    uint64_t failed = 0;
+    std::mutex mutex;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < connections; i++) {
+        threads.emplace_back(Run, i, std::cref(image), std::ref(rtt), std::ref(failed), std::ref(mutex));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("\r\n----- %d connections x %d requests, depth %d -----\r\n", connections, requests, depth);
+    std::printf("throughput: %.1f req/s, failed: %lu\r\n", rtt.Count() / elapsed, failed);
+    rtt.Dump("round trip");
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+#include "infer_server.hpp"
+
+
+std::string socketPath;
+std::vector<std::pair<std::string, std::string>> detectModels;
+std::vector<std::pair<std::string, std::string>> classifyModels;
+int contexts = 3;
+InferServer::Config config;
+
+
+/* 解析 name=path */
+static bool ParseModel(const char* arg, std::vector<std::pair<std::string, std::string>>& models)
+{
+    std::string s(arg);
+    auto pos = s.find('=');
+    if (pos == std::string::npos) {
+        std::printf("invalid model %s, expect name=path\r\n", arg);
+        return false;
+    }
+    models.emplace_back(s.substr(0, pos), s.substr(pos + 1));
+    return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 2) {
+        std::printf("Usage: %s <socket> [-d name=model] [-c name=model] [-x contexts] [-w window] [-b batch] [-q depth]\r\n", argv[0]);
+        return -1;
+    }
+
+    socketPath.assign(argv[1]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "d:c:x:w:b:q:")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 检测模型 */
+            case 'd':
+                ParseModel(optarg, detectModels);
+                break;
+
+            /* 分类模型 */
+            case 'c':
+                ParseModel(optarg, classifyModels);
+                break;
+
+            /* 每个模型的推理上下文数 */
+            case 'x':
+                contexts = std::atoi(optarg);
+                break;
+
+            /* 聚合窗口(us) */
+            case 'w':
+                config.window = std::atol(optarg);
+                break;
+
+            /* 单批最大请求数 */
+            case 'b':
+                config.maxBatch = std::atoi(optarg);
+                break;
+
+            /* 每个模型的最大排队请求数 */
+            case 'q':
+                config.queueDepth = std::atoi(optarg);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    InferServer server(socketPath, config);
+    for (auto& [name, path] : detectModels) {
+        server.AddDetect(name, path, contexts);
+    }
+    for (auto& [name, path] : classifyModels) {
+        server.AddClassify(name, path, contexts);
+    }
+    if (!server.Start()) {
+        return -1;
+    }
+    std::printf("listening on %s\r\n", socketPath.c_str());
+
+    /* 定期输出队列深度、批大小及延迟统计 */
+    while (1) {
+        std::this_thread::sleep_for(std::chrono::seconds(5));
+        server.Dump();
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <unistd.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "jpeg_reader.hpp"
+
+
+std::string imageDir;
+int width = 640;
+int height = 640;
+int iterations = 3;
+
+
+/* 等比缩放到输入尺寸内，模拟letterbox前的缩放开销 */
+static void Fit(const cv::Mat& src, cv::Mat& dst)
+{
+    Transformation trans({src.cols, src.rows}, {width, height});
+    cv::resize(src, dst, cv::Size(std::max(1, static_cast<int>(src.cols * trans.scale)),
+                                  std::max(1, static_cast<int>(src.rows * trans.scale))));
+}
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 2) {
+        std::printf("Usage: %s <image dir> [-W width] [-H height] [-i iterations]\r\n", argv[0]);
+        return -1;
+    }
+
+    imageDir.assign(argv[1]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "W:H:i:")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 模型输入尺寸 */
+            case 'W':
+                width = std::atoi(optarg);
+                break;
+
+            case 'H':
+                height = std::atoi(optarg);
+                break;
+
+            /* 每张图片重复次数 */
+            case 'i':
+                iterations = std::atoi(optarg);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    std::vector<std::string> images;
+    for (auto& entry : std::filesystem::directory_iterator(imageDir)) {
+        auto ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".jpg" || ext == ".jpeg") {
+            images.push_back(entry.path().string());
+        }
+    }
+    if (images.empty()) {
+        std::printf("no jpeg found in %s\r\n", imageDir.c_str());
+        return -1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    int64_t cvCost = 0;
+    int64_t readerCost = 0;
+    int count = 0;
+    uint64_t denominators[9] = {0};
+    JpegReader reader;
+    cv::Mat resized;
+    for (int it = 0; it < iterations; it++) {
+        for (auto& path : images) {
+            /* OpenCV全尺寸解码后缩放 */
+            auto t1 = Clock::now();
+            cv::Mat img = cv::imread(path);
+            if (img.empty()) {
+                continue;
+            }
+            Fit(img, resized);
+            auto t2 = Clock::now();
+
+            /* DCT域缩小解码后缩放 */
+            if (!reader.Read(path, {width, height})) {
+                continue;
+            }
+            Size size = reader.GetSize();
+            cv::Mat decoded(size.height, size.width, CV_8UC3, const_cast<uint8_t*>(reader.Data()));
+            Fit(decoded, resized);
+            auto t3 = Clock::now();
+
+            cvCost += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            readerCost += std::chrono::duration_cast<std::chrono::microseconds>(t3 - t2).count();
+            denominators[reader.GetDenominator()]++;
+            count++;
+        }
+    }
+
+    std::printf("\r\n----- %d decodes of %ld images to %dx%d -----\r\n", count, images.size(), width, height);
+    std::printf("cv::imread + resize: %.2f ms/image\r\n", count > 0 ? cvCost / 1000. / count : 0.);
+    std::printf("JpegReader + resize: %.2f ms/image (%.2fx)\r\n",
+                count > 0 ? readerCost / 1000. / count : 0.,
+                readerCost > 0 ? cvCost / 1. / readerCost : 0.);
+    std::printf("scale 1/1: %lu, 1/2: %lu, 1/4: %lu, 1/8: %lu\r\n",
+                denominators[1],
+                denominators[2],
+                denominators[4],
+                denominators[8]);
+
+    return 0;
+}
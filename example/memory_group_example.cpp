@@ -0,0 +1,77 @@
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <unistd.h>
+
+#include "engine.hpp"
+#include "memory_group.hpp"
+#include "histogram.hpp"
+
+
+std::vector<std::string> modelPaths;
+std::string heap = "/dev/dma_heap/system";
+int iterations = 100;
+bool separate = false;
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "i:d:s")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 每个模型的推理次数 */
+            case 'i':
+                iterations = std::atoi(optarg);
+                break;
+
+            /* 分配共享内存的DMA堆 */
+            case 'd':
+                heap.assign(optarg);
+                break;
+
+            /* 对照组：各模型独立分配内部内存 */
+            case 's':
+                separate = true;
+                break;
+
+            default:
+                break;
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        modelPaths.emplace_back(argv[i]);
+    }
+    if (modelPaths.empty()) {
+        std::printf("Usage: %s [-i iterations] [-d heap] [-s] <model> [model...]\r\n", argv[0]);
+        return -1;
+    }
+
+    /* 组须在引擎之前构造，之后析构 */
+    MemoryGroup group(heap);
+    std::vector<std::unique_ptr<Engine>> engines;
+    for (auto &&path : modelPaths) {
+        engines.push_back(std::make_unique<Engine>(path, Engine::MemoryMode::Default, separate ? nullptr : &group));
+    }
+
+    /* 各模型轮流推理，模拟检测、分类、分割顺序执行的流水线 */
+    std::vector<Histogram> latency(engines.size());
+    for (int i = 0; i < iterations; i++) {
+        for (size_t k = 0; k < engines.size(); k++) {
+            engines[k]->Inference();
+            latency[k].Add(engines[k]->GetTimeCost().inference);
+        }
+    }
+
+    for (size_t k = 0; k < engines.size(); k++) {
+        latency[k].Dump(modelPaths[k].c_str());
+    }
+    if (!separate) {
+        group.Dump();
+    }
+
+    return 0;
+}
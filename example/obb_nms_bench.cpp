@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <unistd.h>
+
+#include "ops.hpp"
+#include "histogram.hpp"
+
+
+int candidates = 4000;
+int classes = 15;
+int iterations = 20;
+float threshold = 0.7f;
+float clusterRatio = 0.6f;
+
+
+/* 逐对精确求交的旋转框NMS，作为结果及耗时的对照 */
+std::vector<int> NaiveNMS(const std::vector<RotatedRect>& boxes,
+                          const std::vector<float>& scores,
+                          const std::vector<int>& classes,
+                          float threshold)
+{
+    std::vector<int> order(boxes.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](const int& a, const int& b) {
+        return classes[a] != classes[b] ? classes[a] < classes[b] : scores[a] > scores[b];
+    });
+
+    std::vector<int> result;
+    std::vector<uint8_t> removed(order.size(), 0);
+    for (size_t i = 0; i < order.size(); i++) {
+        if (removed[i]) {
+            continue;
+        }
+        result.push_back(order[i]);
+        for (size_t j = i + 1; j < order.size() && classes[order[j]] == classes[order[i]]; j++) {
+            if (!removed[j] && Utils::RotatedIoU(boxes[order[i]], boxes[order[j]]) > threshold) {
+                removed[j] = 1;
+            }
+        }
+    }
+    return result;
+}
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "n:c:i:t:r:h")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 候选框数 */
+            case 'n':
+                candidates = std::atoi(optarg);
+                break;
+
+            /* 类别数 */
+            case 'c':
+                classes = std::max(std::atoi(optarg), 1);
+                break;
+
+            /* 迭代次数 */
+            case 'i':
+                iterations = std::max(std::atoi(optarg), 1);
+                break;
+
+            /* NMS阈值 */
+            case 't':
+                threshold = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* 聚集在已有目标附近的候选框比例，模拟同一目标被多个网格检出 */
+            case 'r':
+                clusterRatio = static_cast<float>(std::atof(optarg));
+                break;
+
+            default:
+                std::printf("Usage: %s [-n candidates] [-c classes] [-i iterations] [-t threshold] [-r clusterRatio]\r\n", argv[0]);
+                return -1;
+        }
+    }
+
+    /* 生成1024x1024画面内的随机旋转框，部分候选框围绕已有目标抖动 */
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    std::vector<RotatedRect> boxes;
+    std::vector<float> scores;
+    std::vector<int> ids;
+    int objects = std::max(1, static_cast<int>(candidates * (1.f - clusterRatio)));
+    for (int i = 0; i < candidates; i++) {
+        if (i < objects) {
+            boxes.emplace_back(uniform(rng) * 1024.f, uniform(rng) * 1024.f,
+                               16.f + uniform(rng) * 96.f, 8.f + uniform(rng) * 48.f,
+                               uniform(rng) * 3.1416f);
+            ids.push_back(i % classes);
+        } else {
+            int k = static_cast<int>(uniform(rng) * objects) % objects;
+            RotatedRect box = boxes[k];
+            box.cx += (uniform(rng) - 0.5f) * box.width * 0.2f;
+            box.cy += (uniform(rng) - 0.5f) * box.height * 0.2f;
+            box.width *= 0.9f + uniform(rng) * 0.2f;
+            box.height *= 0.9f + uniform(rng) * 0.2f;
+            box.angle += (uniform(rng) - 0.5f) * 0.2f;
+            boxes.push_back(box);
+            ids.push_back(ids[k]);
+        }
+        scores.push_back(0.25f + uniform(rng) * 0.75f);
+    }
+
+    /* 交替运行两种实现 */
+    Histogram fast;
+    Histogram naive;
+    Utils::RotatedNMSStats stats;
+    std::vector<int> keep;
+    std::vector<int> reference;
+    for (int i = 0; i < iterations; i++) {
+        auto t1 = std::chrono::steady_clock::now();
+        stats = Utils::RotatedNMSStats();
+        keep = Utils::RotatedNMS(boxes, scores, ids, threshold, &stats);
+        auto t2 = std::chrono::steady_clock::now();
+        reference = NaiveNMS(boxes, scores, ids, threshold);
+        auto t3 = std::chrono::steady_clock::now();
+        fast.Add(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+        naive.Add(std::chrono::duration_cast<std::chrono::microseconds>(t3 - t2).count());
+    }
+
+    std::printf("\r\n----- %d candidates, %d classes, threshold %.2f -----\r\n", candidates, classes, threshold);
+    std::printf("kept: %ld, matches naive: %s\r\n", keep.size(), keep == reference ? "yes" : "no");
+    std::printf("pairs: %lu, polygon intersections: %lu (%.2f%% skipped by bounding-box check)\r\n",
+                stats.pairs,
+                stats.exact,
+                stats.pairs > 0 ? 100. - stats.exact * 100. / stats.pairs : 0.);
+    fast.Dump("rotated nms");
+    naive.Dump("naive nms");
+
+    return keep == reference ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <type_traits>
+#include <chrono>
+#include <unistd.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "yolo_detect.hpp"
+#include "yolo_pose.hpp"
+#include "yolo_v5_detect.hpp"
+#include "yolo_obb.hpp"
+#include "rga.hpp"
+#include "soak_monitor.hpp"
+
+
+std::string modelPath;
+std::string imagePath;
+float scoreThres = 0.25f;
+float nmsThres = 0.7f;
+int iterations = 100;
+std::string task = "detect";
+std::string recordPath;
+bool reuse = false;
+Engine::MemoryMode memoryMode = Engine::MemoryMode::Default;
+int64_t soakDuration = 0;
+int64_t soakPeriod = 0;
+uint64_t reinitEvery = 0;
+
+
+/* 循环推理，统计后处理耗时及类别遍历前被拒绝的网格比例 */
+/* 浸泡模式下按时长运行，周期检查内存增长及延迟漂移，超出界限时返回false */
+template<typename Model>
+bool Bench(Model& model, const void* data, size_t len)
+{
+    int64_t postprocess = 0;
+    uint64_t cells = 0;
+    uint64_t skipped = 0;
+    uint64_t pairs = 0;
+    uint64_t exact = 0;
+    size_t objects = 0;
+    DetectionBuffer buffer;
+    SoakMonitor::Config config;
+    if (soakPeriod > 0) {
+        /* 缩短采样周期时预热不超过三个周期 */
+        config.period = soakPeriod;
+        config.warmup = std::min(config.warmup, soakPeriod * 3);
+    }
+    SoakMonitor monitor(config);
+    auto end = SoakMonitor::Clock::now() + std::chrono::seconds(soakDuration);
+    uint64_t n = 0;
+    for (uint64_t i = 0; soakDuration > 0 ? SoakMonitor::Clock::now() < end && !monitor.Failed() : i < static_cast<uint64_t>(iterations); i++, n++) {
+        /* 周期性释放并重新初始化模型，检查上下文及张量内存是否泄漏 */
+        if (reinitEvery > 0 && i > 0 && i % reinitEvery == 0) {
+            model.Deinit();
+            model.Init(modelPath);
+        }
+
+        auto t1 = SoakMonitor::Clock::now();
+        if constexpr (std::is_same_v<Model, YoloDetect>) {
+            /* 复用SoA结果缓冲 */
+            if (reuse) {
+                model.Predict(data, len, buffer);
+                objects = buffer.Size();
+            } else {
+                objects = model.Predict(data, len)->size();
+            }
+        } else if constexpr (std::is_same_v<Model, YoloPose>) {
+            objects = model.Predict(data, len)->objects.size();
+        } else {
+            objects = model.Predict(data, len)->size();
+        }
+        auto t2 = SoakMonitor::Clock::now();
+        if (soakDuration > 0) {
+            monitor.Add(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+        }
+        if (i == 0 && !recordPath.empty()) {
+            model.Record(recordPath);
+        }
+        postprocess += model.GetTimeCost().postprocess;
+        cells += model.GetDecodeStats().cells;
+        skipped += model.GetDecodeStats().skipped;
+        if constexpr (std::is_same_v<Model, YoloObb>) {
+            pairs += model.GetNMSStats().pairs;
+            exact += model.GetNMSStats().exact;
+        }
+    }
+
+    std::printf("\r\n----- %s: %lu iterations, %ld objects -----\r\n", task.c_str(), n, objects);
+    std::printf("postprocess: %.1f us/frame\r\n", n > 0 ? postprocess / 1. / n : 0.);
+    std::printf("preprocess: %ld us, inference: %ld us (last frame)\r\n",
+                model.GetTimeCost().preprocess,
+                model.GetTimeCost().inference);
+    std::printf("cells: %lu, skipped before class scan: %lu (%.2f%%)\r\n",
+                cells,
+                skipped,
+                cells > 0 ? skipped * 100. / cells : 0.);
+    if constexpr (std::is_same_v<Model, YoloObb>) {
+        std::printf("rotated nms pairs: %lu, polygon intersections: %lu (%.2f%% skipped by bounding-box check)\r\n",
+                    pairs,
+                    exact,
+                    pairs > 0 ? 100. - exact * 100. / pairs : 0.);
+    }
+
+    if (soakDuration > 0) {
+        monitor.Sample();
+        monitor.Dump();
+        return !monitor.Failed();
+    }
+    return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 3) {
+        std::printf("Usage: %s <model|record> <image> [-t detect|pose|v5|obb] [-i iterations] [-s scoreThres] [-n nmsThres] [-r record] [-b] [-c default|uncached|cached] [-d soakSeconds] [-p samplePeriodMs] [-R reinitEvery]\r\n", argv[0]);
+        return -1;
+    }
+
+    modelPath.assign(argv[1]);
+    imagePath.assign(argv[2]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "t:i:s:n:r:bc:d:p:R:")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 任务类型 */
+            case 't':
+                task.assign(optarg);
+                break;
+
+            /* 迭代次数 */
+            case 'i':
+                iterations = std::atoi(optarg);
+                break;
+
+            /* 分数阈值 */
+            case 's':
+                scoreThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* NMS阈值 */
+            case 'n':
+                nmsThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* 录制输出张量，供无NPU环境回放 */
+            case 'r':
+                recordPath.assign(optarg);
+                break;
+
+            /* 检测任务使用可复用的结果缓冲 */
+            case 'b':
+                reuse = true;
+                break;
+
+            /* 输入输出张量内存方式，用于对比CPU读取输出的耗时 */
+            case 'c':
+                if (std::strcmp(optarg, "uncached") == 0) {
+                    memoryMode = Engine::MemoryMode::Uncached;
+                } else if (std::strcmp(optarg, "cached") == 0) {
+                    memoryMode = Engine::MemoryMode::Cached;
+                } else {
+                    memoryMode = Engine::MemoryMode::Default;
+                }
+                break;
+
+            /* 浸泡时长(s)，指定后忽略迭代次数 */
+            case 'd':
+                soakDuration = std::atol(optarg);
+                break;
+
+            /* 浸泡采样周期(ms) */
+            case 'p':
+                soakPeriod = std::atol(optarg) * 1000;
+                break;
+
+            /* 每隔若干次推理重新初始化模型 */
+            case 'R':
+                reinitEvery = std::strtoull(optarg, nullptr, 10);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* 加载模型，后缀为.rec时回放录制的输出张量 */
+    std::unique_ptr<YoloDetect> detect;
+    std::unique_ptr<YoloPose> pose;
+    std::unique_ptr<YoloV5Detect> v5;
+    std::unique_ptr<YoloObb> obb;
+    Size inputSize;
+    if (task == "pose") {
+        pose = std::make_unique<YoloPose>(modelPath, scoreThres, nmsThres, memoryMode);
+        inputSize = pose->GetInputSize();
+    } else if (task == "v5") {
+        v5 = std::make_unique<YoloV5Detect>(modelPath, scoreThres, nmsThres, YoloV5Detect::defaultAnchors, memoryMode);
+        inputSize = v5->GetInputSize();
+    } else if (task == "obb") {
+        obb = std::make_unique<YoloObb>(modelPath, scoreThres, nmsThres, memoryMode);
+        inputSize = obb->GetInputSize();
+    } else {
+        detect = std::make_unique<YoloDetect>(modelPath, scoreThres, nmsThres, memoryMode);
+        inputSize = detect->GetInputSize();
+    }
+
+    /* 加载图片 */
+    cv::Mat img = cv::imread(imagePath);
+    std::printf("Read image %s\r\n", imagePath.c_str());
+    auto& input = rga->Run(
+        {
+            (void*) img.data,
+            Rga::Virtual,
+            {
+                img.cols,
+                img.rows,
+                RK_FORMAT_BGR_888
+            }
+        },
+        {
+            inputSize.width,
+            inputSize.height,
+            RK_FORMAT_RGB_888
+        }
+    );
+
+    bool passed = true;
+    if (pose) {
+        passed = Bench(*pose, input.addr, input.len);
+    } else if (v5) {
+        passed = Bench(*v5, input.addr, input.len);
+    } else if (obb) {
+        passed = Bench(*obb, input.addr, input.len);
+    } else {
+        passed = Bench(*detect, input.addr, input.len);
+    }
+
+    return passed ? 0 : 1;
+}
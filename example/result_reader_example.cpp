@@ -0,0 +1,76 @@
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+#include "result_ring.hpp"
+
+
+std::string ringName;
+bool verbose = false;
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 2) {
+        std::printf("Usage: %s <ring> [-v]\r\n", argv[0]);
+        return -1;
+    }
+
+    ringName.assign(argv[1]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "v")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 打印每帧检测结果 */
+            case 'v':
+                verbose = true;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    ResultReader reader(ringName);
+    if (!reader.IsOpen()) {
+        return -1;
+    }
+
+    /* 轮询读取，每秒输出一次读取帧率及丢帧数 */
+    ResultRing::Frame frame;
+    uint64_t frames = 0;
+    auto last = std::chrono::steady_clock::now();
+    while (1) {
+        if (reader.Next(frame)) {
+            frames++;
+            if (verbose) {
+                std::printf("frame %lu @ %ld us, %u objects\r\n", frame.frameId, frame.timestamp, frame.count);
+                for (uint32_t i = 0; i < frame.count; i++) {
+                    std::printf("  %d [%.2f, %.2f, %.2f, %.2f] @ %.2f\r\n",
+                                frame.classes[i],
+                                frame.x[i],
+                                frame.y[i],
+                                frame.width[i],
+                                frame.height[i],
+                                frame.score[i]);
+                }
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last >= std::chrono::seconds(1)) {
+            std::printf("read: %lu fps, lost: %lu\r\n", frames, reader.GetLost());
+            frames = 0;
+            last = now;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,519 @@
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <unistd.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "yolo_detect.hpp"
+#include "classify.hpp"
+#include "jpeg_reader.hpp"
+#include "letterbox.hpp"
+#include "detection_eval.hpp"
+#include "cpu_topology.hpp"
+
+
+using Clock = std::chrono::steady_clock;
+
+std::string modelPath;
+std::string imageDir;
+std::string task = "detect";
+std::string annotationPath;
+std::string outputPath;
+int decodeThreads = 2;
+int prefetch = 8;
+float scoreThres = 0.001f;
+float nmsThres = 0.7f;
+int topk = 5;
+size_t limit = 0;
+bool placement = false;
+std::string classMap = "coco";
+
+
+/* 预取槽位，解码线程写入，推理线程读取后归还 */
+struct Slot
+{
+    size_t index {0};
+    bool ok {false};
+    std::vector<uint8_t> data;  // letterbox后的RGB888模型输入
+    Transformation trans;
+    Size original;
+};
+
+
+/* 有界预取队列，解码线程与推理线程之间通过空闲/就绪两个队列传递槽位 */
+class Prefetcher
+{
+public:
+    using ThreadInit = std::function<void(int thread)>;  // 解码线程启动时在该线程上调用，用于绑核等设置
+
+    Prefetcher(const std::vector<std::string>& images, const Size& input, int threads, int depth, ThreadInit init = nullptr) :
+    _images(images), _input(input), _slots(depth), _init(std::move(init))
+    {
+        for (auto& slot : _slots) {
+            slot.data.resize(input.size() * 3);
+            _free.push_back(&slot);
+        }
+        for (int i = 0; i < threads; i++) {
+            _threads.emplace_back(&Prefetcher::_Decode, this, i);
+        }
+    }
+
+    ~Prefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cond.notify_all();
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    Slot* Take()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cond.wait(lock, [&] { return !_ready.empty(); });
+        Slot* slot = _ready.front();
+        _ready.pop_front();
+        return slot;
+    }
+
+    void Give(Slot* slot)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _free.push_back(slot);
+        }
+        _cond.notify_all();
+    }
+
+    int64_t GetBusy() const
+    {
+        return _busy;
+    }
+
+private:
+    const std::vector<std::string>& _images;
+    Size _input;
+    std::vector<Slot> _slots;
+    std::deque<Slot*> _free;
+    std::deque<Slot*> _ready;
+    std::vector<std::thread> _threads;
+    ThreadInit _init;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::atomic<size_t> _next {0};
+    std::atomic<int64_t> _busy {0};  // 解码线程累计工作时间(us)
+    bool _stop {false};
+
+    void _Decode(int thread)
+    {
+        if (_init) {
+            _init(thread);
+        }
+
+        JpegReader reader;
+        cv::Mat bgr;
+        while (1) {
+            size_t index = _next++;
+            if (index >= _images.size()) {
+                break;
+            }
+
+            Slot* slot = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cond.wait(lock, [&] { return _stop || !_free.empty(); });
+                if (_stop) {
+                    break;
+                }
+                slot = _free.front();
+                _free.pop_front();
+            }
+
+            auto t1 = Clock::now();
+            slot->index = index;
+            slot->ok = false;
+
+            /* JPEG在DCT域缩小解码，其他格式走OpenCV */
+            cv::Mat img;
+            auto ext = std::filesystem::path(_images[index]).extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if ((ext == ".jpg" || ext == ".jpeg") && reader.Read(_images[index], _input)) {
+                Size size = reader.GetSize();
+                img = cv::Mat(size.height, size.width, CV_8UC3, const_cast<uint8_t*>(reader.Data()));
+                slot->trans = reader.GetTransformation(_input);
+                slot->original = reader.GetOriginalSize();
+            } else {
+                bgr = cv::imread(_images[index]);
+                img = bgr;
+                slot->trans = Transformation({bgr.cols, bgr.rows}, _input);
+                slot->original = {bgr.cols, bgr.rows};
+            }
+
+            if (!img.empty()) {
+                cv::Mat out(_input.height, _input.width, CV_8UC3, slot->data.data());
+                Letterbox(img, _input, out);
+                cv::cvtColor(out, out, cv::COLOR_BGR2RGB);
+                slot->ok = true;
+            }
+            _busy += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t1).count();
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _ready.push_back(slot);
+            }
+            _cond.notify_all();
+        }
+    }
+};
+
+
+/* 文件名为纯数字时(COCO)作为image_id，否则使用序号 */
+static int64_t ImageId(const std::string& path, size_t index)
+{
+    std::string stem = std::filesystem::path(path).stem().string();
+    if (!stem.empty() && std::all_of(stem.begin(), stem.end(), ::isdigit)) {
+        return std::atoll(stem.c_str());
+    }
+    return static_cast<int64_t>(index);
+}
+
+
+/* 读取YOLO格式标注：每行 class cx cy w h，坐标相对原图归一化 */
+static std::vector<DetectionEvaluator::Object> LoadYoloLabel(const std::string& path, const Size& size)
+{
+    std::vector<DetectionEvaluator::Object> objects;
+    std::ifstream ifs(path);
+    int id;
+    float cx, cy, w, h;
+    while (ifs >> id >> cx >> cy >> w >> h) {
+        objects.push_back({id, 1.f, {(cx - w / 2) * size.width, (cy - h / 2) * size.height, w * size.width, h * size.height}});
+    }
+    return objects;
+}
+
+
+/* COCO的80个检测类别在官方标注中的category_id，标注的id不连续 */
+static const std::vector<int> cocoCategories = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 14, 15, 16, 17, 18, 19, 20, 21,
+    22, 23, 24, 25, 27, 28, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44,
+    46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65,
+    67, 70, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 84, 85, 86, 87, 88, 89, 90,
+};
+
+
+/* 读取类别映射：第i行为模型第i类对应的category_id */
+static std::vector<int> LoadClassMap(const std::string& path)
+{
+    std::vector<int> categories;
+    std::ifstream ifs(path);
+    if (!ifs) {
+        std::printf("open class map %s failed\r\n", path.c_str());
+    }
+    int id;
+    while (ifs >> id) {
+        categories.push_back(id);
+    }
+    return categories;
+}
+
+
+/* 读取分类标注：每行 文件名 类别 */
+static std::map<std::string, int> LoadClassLabel(const std::string& path)
+{
+    std::map<std::string, int> labels;
+    std::ifstream ifs(path);
+    std::string name;
+    int id;
+    while (ifs >> name >> id) {
+        labels[name] = id;
+    }
+    return labels;
+}
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 3) {
+        std::printf("Usage: %s <model|record> <image dir> [-t detect|classify] [-a annotations] [-o output.json] "
+                    "[-j decodeThreads] [-q prefetch] [-s scoreThres] [-n nmsThres] [-k topk] [-l limit] [-p] [-m coco|none|map]\r\n", argv[0]);
+        return -1;
+    }
+
+    modelPath.assign(argv[1]);
+    imageDir.assign(argv[2]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "t:a:o:j:q:s:n:k:l:pm:")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 任务类型 */
+            case 't':
+                task.assign(optarg);
+                break;
+
+            /* 标注，检测为YOLO格式标注目录，分类为标注文件 */
+            case 'a':
+                annotationPath.assign(optarg);
+                break;
+
+            /* 结果输出为COCO格式json */
+            case 'o':
+                outputPath.assign(optarg);
+                break;
+
+            /* 解码线程数 */
+            case 'j':
+                decodeThreads = std::max(1, std::atoi(optarg));
+                break;
+
+            /* 预取深度 */
+            case 'q':
+                prefetch = std::max(1, std::atoi(optarg));
+                break;
+
+            /* 分数阈值，评估mAP时应足够低 */
+            case 's':
+                scoreThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* NMS阈值 */
+            case 'n':
+                nmsThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* 分类输出前k个 */
+            case 'k':
+                topk = std::atoi(optarg);
+                break;
+
+            /* 最多评估图片数 */
+            case 'l':
+                limit = std::atol(optarg);
+                break;
+
+            /* 推理线程绑定大核，解码线程绑定小核 */
+            case 'p':
+                placement = true;
+                break;
+
+            /* 输出json时模型类别到category_id的映射，coco为内置的80类映射，none为不映射，其他为映射文件 */
+            case 'm':
+                classMap.assign(optarg);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* 遍历图片目录 */
+    std::vector<std::string> images;
+    for (auto& entry : std::filesystem::directory_iterator(imageDir)) {
+        auto ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp") {
+            images.push_back(entry.path().string());
+        }
+    }
+    std::sort(images.begin(), images.end());
+    if (limit > 0 && images.size() > limit) {
+        images.resize(limit);
+    }
+    if (images.empty()) {
+        std::printf("no image found in %s\r\n", imageDir.c_str());
+        return -1;
+    }
+
+    /* 加载模型，后缀为.rec时回放录制的输出张量，不使用NPU */
+    bool detect = task != "classify";
+    std::unique_ptr<YoloDetect> detector;
+    std::unique_ptr<Classify> classifier;
+    Size inputSize;
+    if (detect) {
+        detector = std::make_unique<YoloDetect>(modelPath, scoreThres, nmsThres);
+        inputSize = detector->GetInputSize();
+    } else {
+        classifier = std::make_unique<Classify>(modelPath, topk);
+        inputSize = classifier->GetInputSize();
+    }
+    if (inputSize.size() == 0) {
+        std::printf("load model %s failed\r\n", modelPath.c_str());
+        return -1;
+    }
+
+    std::vector<int> categories;
+    if (classMap == "coco") {
+        categories = cocoCategories;
+    } else if (classMap != "none") {
+        categories = LoadClassMap(classMap);
+        if (categories.empty()) {
+            return -1;
+        }
+    }
+
+    FILE* output = outputPath.empty() ? nullptr : std::fopen(outputPath.c_str(), "w");
+    if (!outputPath.empty() && output == nullptr) {
+        std::printf("open %s failed\r\n", outputPath.c_str());
+        return -1;
+    }
+    if (output) {
+        std::fprintf(output, "[");
+    }
+
+    DetectionEvaluator evaluator;
+    std::map<std::string, int> classLabels;
+    if (!detect && !annotationPath.empty()) {
+        classLabels = LoadClassLabel(annotationPath);
+    }
+    size_t top1 = 0;
+    size_t top5 = 0;
+    size_t labeled = 0;
+    size_t failed = 0;
+    bool first = true;
+
+    /* 推理线程按就绪顺序消费，各阶段耗时分别累计 */
+    DetectionBuffer detections;
+    ClassBuffer classes;
+    int64_t waitCost = 0;
+    int64_t preprocessCost = 0;
+    int64_t inferenceCost = 0;
+    int64_t postprocessCost = 0;
+    int64_t writeCost = 0;
+    CpuTopology topology;
+    Prefetcher::ThreadInit init;
+    if (placement) {
+        topology.Place("infer", CpuTopology::Critical);
+        init = [&](int thread) {
+            topology.Place("decode" + std::to_string(thread), CpuTopology::Background);
+        };
+    }
+    auto start = Clock::now();
+    {
+        Prefetcher prefetcher(images, inputSize, decodeThreads, prefetch, init);
+        for (size_t n = 0; n < images.size(); n++) {
+            auto t1 = Clock::now();
+            Slot* slot = prefetcher.Take();
+            auto t2 = Clock::now();
+            waitCost += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            if (!slot->ok) {
+                failed++;
+                prefetcher.Give(slot);
+                continue;
+            }
+
+            const std::string& path = images[slot->index];
+            int64_t imageId = ImageId(path, slot->index);
+            if (detect) {
+                detector->Predict(slot->data.data(), slot->data.size(), detections, &slot->trans);
+                auto& cost = detector->GetTimeCost();
+                preprocessCost += cost.preprocess;
+                inferenceCost += cost.inference;
+                postprocessCost += cost.postprocess;
+            } else {
+                classifier->Predict(slot->data.data(), slot->data.size(), classes);
+                auto& cost = classifier->GetTimeCost();
+                preprocessCost += cost.preprocess;
+                inferenceCost += cost.inference;
+                postprocessCost += cost.postprocess;
+            }
+            Size original = slot->original;
+            prefetcher.Give(slot);
+
+            /* 输出结果并统计精度 */
+            auto t3 = Clock::now();
+            std::string name = std::filesystem::path(path).filename().string();
+            if (detect) {
+                std::vector<DetectionEvaluator::Object> objects;
+                for (auto det : detections) {
+                    objects.push_back({det.id, det.score, det.box});
+                    if (output) {
+                        std::fprintf(output, "%s\n{\"image_id\": %ld, \"category_id\": %d, \"bbox\": [%.2f, %.2f, %.2f, %.2f], \"score\": %.5f}",
+                                     first ? "" : ",",
+                                     imageId,
+                                     det.id >= 0 && det.id < static_cast<int>(categories.size()) ? categories[det.id] : det.id,
+                                     det.box.x,
+                                     det.box.y,
+                                     det.box.width,
+                                     det.box.height,
+                                     det.score);
+                        first = false;
+                    }
+                }
+                if (!annotationPath.empty()) {
+                    auto label = std::filesystem::path(annotationPath) / std::filesystem::path(path).stem();
+                    evaluator.Add(LoadYoloLabel(label.string() + ".txt", original), objects);
+                }
+            } else {
+                if (output) {
+                    std::fprintf(output, "%s\n{\"image\": \"%s\", \"topk\": [", first ? "" : ",", name.c_str());
+                    for (size_t i = 0; i < classes.Size(); i++) {
+                        std::fprintf(output, "%s[%u, %.5f]", i == 0 ? "" : ", ", classes.Ids()[i], classes.Scores()[i]);
+                    }
+                    std::fprintf(output, "]}");
+                    first = false;
+                }
+                auto it = classLabels.find(name);
+                if (it != classLabels.end()) {
+                    labeled++;
+                    auto ids = classes.Ids().first(std::min<size_t>(5, classes.Size()));
+                    uint32_t truth = static_cast<uint32_t>(it->second);
+                    top1 += !ids.empty() && ids[0] == truth;
+                    top5 += std::find(ids.begin(), ids.end(), truth) != ids.end();
+                }
+            }
+            writeCost += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t3).count();
+        }
+
+        /* 汇总解码耗时 */
+        double wall = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        size_t done = images.size() - failed;
+        std::printf("\r\n----- %ld images (%ld failed) in %.2f s, %.1f images/s -----\r\n",
+                    images.size(),
+                    failed,
+                    wall / 1e6,
+                    done / (wall / 1e6));
+        std::printf("decode: %.1f%% of %d threads\r\n", prefetcher.GetBusy() * 100. / (wall * decodeThreads), decodeThreads);
+        std::printf("wait: %.1f%%, preprocess: %.1f%%, inference: %.1f%%, postprocess: %.1f%%, output: %.1f%%\r\n",
+                    waitCost * 100. / wall,
+                    preprocessCost * 100. / wall,
+                    inferenceCost * 100. / wall,
+                    postprocessCost * 100. / wall,
+                    writeCost * 100. / wall);
+        if (placement) {
+            topology.Dump();
+        }
+    }
+
+    if (output) {
+        std::fprintf(output, "\n]\n");
+        std::fclose(output);
+        std::printf("results written to %s\r\n", outputPath.c_str());
+    }
+
+    if (detect && evaluator.GetImageNum() > 0) {
+        std::printf("mAP@0.5: %.4f, mAP@0.5:0.95: %.4f\r\n", evaluator.MeanAP(0.5f), evaluator.MeanAP());
+    } else if (!detect && labeled > 0) {
+        std::printf("top1: %.4f, top5: %.4f (%ld labeled)\r\n", top1 / 1. / labeled, top5 / 1. / labeled, labeled);
+    }
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include <string>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <unistd.h>
+
+#include "scheduler.hpp"
+#include "yolo_detect.hpp"
+#include "variant_controller.hpp"
+#include "cpu_topology.hpp"
+#include "thermal_governor.hpp"
+
+
+std::string modelPath;
+std::vector<std::string> variantPaths;
+int streams = 16;
+int workers = 3;
+int fps = 30;
+int64_t slo = 100000;
+int duration = 10;
+bool placement = false;
+int fifoPriority = 0;
+std::string governorRoot;
+std::string metricsPath;
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "m:v:s:w:f:o:d:ar:g:e:h")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 模型，模拟推理耗时见scheduler-sim */
+            case 'm':
+                modelPath.assign(optarg);
+                break;
+
+            /* 由重到轻的多个模型规格，逗号分隔，按负载自动切换 */
+            case 'v': {
+                std::istringstream iss(optarg);
+                std::string path;
+                while (std::getline(iss, path, ',')) {
+                    variantPaths.push_back(path);
+                }
+                break;
+            }
+
+            /* 视频流数 */
+            case 's':
+                streams = std::atoi(optarg);
+                break;
+
+            /* 推理上下文数 */
+            case 'w':
+                workers = std::atoi(optarg);
+                break;
+
+            /* 每路帧率 */
+            case 'f':
+                fps = std::atoi(optarg);
+                break;
+
+            /* 延迟目标(us) */
+            case 'o':
+                slo = std::atol(optarg);
+                break;
+
+            /* 运行时长(s) */
+            case 'd':
+                duration = std::atoi(optarg);
+                break;
+
+            /* 工作线程及驱动线程绑定大核 */
+            case 'a':
+                placement = true;
+                break;
+
+            /* 绑核线程使用SCHED_FIFO及其优先级 */
+            case 'r':
+                fifoPriority = std::atoi(optarg);
+                break;
+
+            /* 启用温控，参数为sysfs/debugfs所在的根目录，目标板上为/ */
+            case 'g':
+                governorRoot.assign(optarg);
+                break;
+
+            /* 温控指标导出文件，Prometheus文本格式 */
+            case 'e':
+                metricsPath.assign(optarg);
+                break;
+
+            default:
+                std::printf("Usage: %s [-m model | -v model1,model2,...] [-s streams] [-w workers] [-f fps] [-o slo] [-d duration] [-a] [-r fifoPriority] [-g root] [-e metrics]\r\n", argv[0]);
+                return -1;
+        }
+    }
+
+    /* 每个推理上下文一个模型实例 */
+    std::vector<std::unique_ptr<YoloDetect>> models;
+    std::vector<std::unique_ptr<VariantController>> controllers;
+    std::vector<uint8_t> frame;
+    if (!variantPaths.empty()) {
+        VariantController::Config config;
+        config.budget = slo;
+        for (int i = 0; i < workers; i++) {
+            controllers.push_back(std::make_unique<VariantController>(variantPaths, 0.25f, 0.7f, config));
+        }
+        frame.resize(controllers[0]->Current().GetInputSize().size() * 3);
+    } else if (!modelPath.empty()) {
+        for (int i = 0; i < workers; i++) {
+            models.push_back(std::make_unique<YoloDetect>(modelPath));
+        }
+        frame.resize(models[0]->GetInputSize().size() * 3);
+    } else {
+        std::printf("no model specified, use scheduler-sim for simulated latency\r\n");
+        return -1;
+    }
+
+    /* 推理工作线程及驱动线程绑定大核 */
+    CpuTopology topology;
+    Scheduler::ThreadInit init;
+    if (placement) {
+        init = [&](int worker) {
+            topology.Place("worker" + std::to_string(worker), CpuTopology::Critical, fifoPriority);
+        };
+        topology.Place("driver", CpuTopology::Critical, fifoPriority);
+    }
+    Scheduler scheduler(workers, init);
+
+    /* 后一半视频流优先级更高 */
+    for (int i = 0; i < streams; i++) {
+        scheduler.AddStream({slo, i >= streams / 2 ? 1 : 0, 2});
+    }
+
+    /* 温控降档时依次切换轻量模型、减少活跃上下文、降低帧率 */
+    std::atomic<float> fpsScale {1.0f};
+    std::unique_ptr<ThermalGovernor> governor;
+    if (!governorRoot.empty()) {
+        ThermalGovernor::Config config;
+        config.root = governorRoot;
+        int variants = controllers.empty() ? 1 : static_cast<int>(controllers[0]->GetVariantNum());
+        governor = std::make_unique<ThermalGovernor>(ThermalGovernor::MakeLadder(workers, variants), [&](const ThermalGovernor::Step& step) {
+            fpsScale = step.fps;
+            scheduler.SetActiveWorkers(step.contexts);
+            for (auto &controller : controllers) {
+                controller->SetFloor(step.variant);
+            }
+        }, config);
+        governor->Start();
+    }
+
+    /* 按帧率向各路提交帧 */
+    auto end = Scheduler::Clock::now() + std::chrono::seconds(duration);
+    auto next = Scheduler::Clock::now();
+    auto exported = next;
+    for (int n = 0; Scheduler::Clock::now() < end; n++) {
+        if (!controllers.empty()) {
+            auto submit = Scheduler::Clock::now();
+            scheduler.Submit(n % streams, [&, submit](int worker) {
+                controllers[worker]->Predict(frame.data(), frame.size());
+                auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Scheduler::Clock::now() - submit);
+                controllers[worker]->Report(latency.count(), scheduler.GetPending());
+            });
+        } else {
+            scheduler.Submit(n % streams, [&](int worker) {
+                models[worker]->Predict(frame.data(), frame.size());
+            });
+        }
+        next += std::chrono::microseconds(static_cast<int64_t>(1e6 / (fps * fpsScale) / streams));
+        std::this_thread::sleep_until(next);
+
+        if (governor && !metricsPath.empty() && next - exported >= std::chrono::seconds(1)) {
+            governor->Export(metricsPath);
+            exported = next;
+        }
+    }
+    if (governor) {
+        governor->Stop();
+        governor->Dump();
+        if (!metricsPath.empty()) {
+            governor->Export(metricsPath);
+        }
+    }
+    if (placement) {
+        topology.Dump();
+    }
+    scheduler.Stop();
+    scheduler.Dump();
+    for (size_t i = 0; i < controllers.size(); i++) {
+        std::printf("worker %ld ", i);
+        controllers[i]->Dump();
+    }
+
+    return 0;
+}
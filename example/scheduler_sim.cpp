@@ -0,0 +1,93 @@
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+#include "scheduler.hpp"
+
+
+int streams = 16;
+int workers = 3;
+int fps = 30;
+int64_t latency = 25000;
+int64_t jitter = 5000;
+int64_t slo = 100000;
+int duration = 10;
+
+
+/* 模拟推理耗时的调度器验证，只依赖调度器及直方图，可在无目标板的环境构建运行 */
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "s:w:f:l:j:o:d:h")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 视频流数 */
+            case 's':
+                streams = std::atoi(optarg);
+                break;
+
+            /* 推理上下文数 */
+            case 'w':
+                workers = std::atoi(optarg);
+                break;
+
+            /* 每路帧率 */
+            case 'f':
+                fps = std::atoi(optarg);
+                break;
+
+            /* 模拟推理耗时及抖动(us) */
+            case 'l':
+                latency = std::atol(optarg);
+                break;
+
+            case 'j':
+                jitter = std::atol(optarg);
+                break;
+
+            /* 延迟目标(us) */
+            case 'o':
+                slo = std::atol(optarg);
+                break;
+
+            /* 运行时长(s) */
+            case 'd':
+                duration = std::atoi(optarg);
+                break;
+
+            default:
+                std::printf("Usage: %s [-s streams] [-w workers] [-f fps] [-l latency] [-j jitter] [-o slo] [-d duration]\r\n", argv[0]);
+                return -1;
+        }
+    }
+
+    /* 后一半视频流优先级更高 */
+    Scheduler scheduler(workers);
+    for (int i = 0; i < streams; i++) {
+        scheduler.AddStream({slo, i >= streams / 2 ? 1 : 0, 2});
+    }
+
+    /* 按帧率向各路提交帧，推理耗时按正态分布模拟 */
+    std::mt19937 rng(0);
+    std::normal_distribution<double> dist(static_cast<double>(latency), static_cast<double>(jitter));
+    auto end = Scheduler::Clock::now() + std::chrono::seconds(duration);
+    auto next = Scheduler::Clock::now();
+    for (int n = 0; Scheduler::Clock::now() < end; n++) {
+        auto cost = std::chrono::microseconds(std::max<int64_t>(0, static_cast<int64_t>(dist(rng))));
+        scheduler.Submit(n % streams, [cost](int) {
+            std::this_thread::sleep_for(cost);
+        });
+        next += std::chrono::microseconds(static_cast<int64_t>(1e6 / fps / streams));
+        std::this_thread::sleep_until(next);
+    }
+    scheduler.Stop();
+    scheduler.Dump();
+
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include <string>
 #include <cstring>
 #include <cstdio>
+#include <memory>
+#include <sstream>
+#include <chrono>
 #include <unistd.h>
 
 #include <opencv2/imgproc.hpp>
@@ -9,13 +12,16 @@
 #include "yolo_detect.hpp"
 #include "label.hpp"
 #include "rga.hpp"
+#include "result_ring.hpp"
+#include "cpu_topology.hpp"
 
 #ifdef WITH_PREVIEW
-    #include <sstream>
-    #include <iomanip>
+    #include <thread>
 
-    #include "drawing.hpp"
+    #include "overlay.hpp"
     #include "display.hpp"
+    #include "display_sink.hpp"
+    #include "mpi_display.hpp"
 #endif
 
 
@@ -24,13 +30,16 @@ std::string imagePath;
 Label label;
 float scoreThres = 0.25f;
 float nmsThres = 0.7f;
+std::string ringName;
+std::string classFilter;
+bool placement = false;
 
 
 int main(int argc, char* argv[])
 {
     /* 解析命令行参数 */
     if (argc < 3) {
-        std::printf("Usage: %s <model> <image> [-l label] [-s scoreThres] [-n nmsThres]\r\n", argv[0]);
+        std::printf("Usage: %s <model> <image> [-l label] [-s scoreThres] [-n nmsThres] [-p ring] [-c class[:thres],...] [-a]\r\n", argv[0]);
         return -1;
     }
 
@@ -38,7 +47,7 @@ int main(int argc, char* argv[])
     imagePath.assign(argv[2]);
 
     int opt = -1;
-    while ((opt = getopt(argc, argv, "l:s:n:")) != -1) {
+    while ((opt = getopt(argc, argv, "l:s:n:p:c:a")) != -1) {
         switch (static_cast<char>(opt))
         {
             /* 类别标签 */
@@ -57,25 +66,69 @@ int main(int argc, char* argv[])
                 nmsThres = static_cast<float>(std::atof(optarg));
                 break;
 
+            /* 检测结果发布到共享内存，供下游进程读取 */
+            case 'p':
+                ringName.assign(optarg);
+                break;
+
+            /* 只检测指定类别，可为每个类别单独指定阈值 */
+            case 'c':
+                classFilter.assign(optarg);
+                break;
+
+            /* 推理线程绑定大核，显示线程绑定小核 */
+            case 'a':
+                placement = true;
+                break;
+
             default:
                 break;
         }
     }
 
+    CpuTopology topology;
+    if (placement) {
+        topology.Place("pipeline", CpuTopology::Critical);
+    }
+
 #ifdef WITH_PREVIEW
     /* 初始化屏幕 */
     Mpi::Init();
     Display display(VO_INTF_MIPI, {800, 1280, RK_FMT_RGBA8888, ROTATION_90}, 1, 2, 4);
-    auto screen = display.GetFrame(0);
+    MpiDisplay screen(display, 3, {1280, 800});
+    DisplaySink sink(screen, 60, [&]() {
+        if (placement) {
+            topology.Place("display", CpuTopology::Background);
+        }
+    });
 #endif
 
+    std::unique_ptr<ResultPublisher> publisher;
+    if (!ringName.empty()) {
+        publisher = std::make_unique<ResultPublisher>(ringName);
+    }
+
     /* 加载模型 */
     YoloDetect model(modelPath, scoreThres, nmsThres);
-    auto inputSize = model.GetInputSize();
+    if (!classFilter.empty()) {
+        YoloDetect::ClassFilter filter;
+        std::istringstream iss(classFilter);
+        std::string item;
+        while (std::getline(iss, item, ',')) {
+            auto pos = item.find(':');
+            filter.classes.push_back(std::atoi(item.substr(0, pos).c_str()));
+            filter.thresholds.push_back(pos == std::string::npos ? scoreThres : std::atof(item.substr(pos + 1).c_str()));
+        }
+        model.SetClassFilter(filter);
+    }
 
     /* 加载图片 */
     cv::Mat img = cv::imread(imagePath);
     std::printf("Read image %s\r\n", imagePath.c_str());
+
+    /* 动态输入模型选择与画面比例最匹配的最小输入尺寸 */
+    auto inputSize = model.SelectInputSize({img.cols, img.rows});
+    std::printf("Input size %dx%d\r\n", inputSize.width, inputSize.height);
     auto& input = rga->Run(
         {
             (void*) img.data,
@@ -97,22 +150,6 @@ int main(int argc, char* argv[])
     auto results = model.Predict(input.addr, input.len);
     std::printf("\r\n----- Got %ld objects -----\r\n", results->size());
     for (auto &&result : *results) {
-#ifdef WITH_PREVIEW
-        std::ostringstream oss;
-        oss << label[result.id] << " @ " << std::setprecision(2) << std::fixed << result.score;
-        Transformation trans({img.cols, img.rows}, inputSize);
-        Rect box = trans.ToOriginal<float, int>(result.box);
-        DrawBox(
-            img,
-            {
-                box.x,
-                box.y,
-                box.width,
-                box.height,
-            },
-            oss.str()
-        );
-#endif
         std::printf("%s [%.2f, %.2f, %.2f, %.2f] @ %.2f\r\n",
                     label[result.id].c_str(),
                     result.box.x,
@@ -122,12 +159,35 @@ int main(int argc, char* argv[])
                     result.score);
     }
 
+    /* 共享内存按列存放，先转为SoA排布再发布 */
+    if (publisher) {
+        DetectionBuffer buffer;
+        buffer.Reserve(results->size());
+        for (auto &&result : *results) {
+            buffer.Push(result.id, result.score, result.box);
+        }
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        publisher->Publish(0, std::chrono::duration_cast<std::chrono::microseconds>(now).count(), {
+            buffer.Ids(),
+            buffer.Scores(),
+            buffer.X(),
+            buffer.Y(),
+            buffer.Width(),
+            buffer.Height()
+        });
+    }
+
     std::printf("preprocess: %ld us, inference: %ld us, postprocess: %ld us\r\n",
                 model.GetTimeCost().preprocess,
                 model.GetTimeCost().inference,
                 model.GetTimeCost().postprocess);
 
 #ifdef WITH_PREVIEW
+    int frame = sink.Acquire();
+    if (frame < 0) {
+        std::printf("no free display frame\r\n");
+        return -1;
+    }
     rga->Run(
         {
             (void*) img.data,
@@ -139,7 +199,7 @@ int main(int argc, char* argv[])
             }
         },
         {
-            screen->pData,
+            sink.GetBuffer(frame),
             Rga::Virtual,
             {
                 1280,
@@ -149,7 +209,38 @@ int main(int argc, char* argv[])
         }    
     );
 
-    while (1);    
+    /* 画面拷贝到屏幕后，在显示缓冲区上一次性叠加所有检测框 */
+    Overlay overlay;
+    std::vector<Overlay::Item> items;
+    Transformation trans({img.cols, img.rows}, inputSize);
+    float sx = 1280.f / img.cols;
+    float sy = 800.f / img.rows;
+    for (auto &&result : *results) {
+        Rect box = trans.ToOriginal<float, int>(result.box);
+        items.push_back({
+            {
+                static_cast<int>(box.x * sx),
+                static_cast<int>(box.y * sy),
+                static_cast<int>(box.width * sx),
+                static_cast<int>(box.height * sy)
+            },
+            label[result.id],
+            result.score
+        });
+    }
+    overlay.Draw(static_cast<uint8_t*>(sink.GetBuffer(frame)), 1280, 800, 1280 * 4, items);
+    sink.Submit(frame);
+
+    /* 显示线程按定时节拍呈现，主线程休眠并定期输出显示统计 */
+    while (1) {
+        std::this_thread::sleep_for(std::chrono::seconds(5));
+        auto stats = sink.GetStats();
+        std::printf("display shown: %lu, dropped: %lu, ", stats.shown, stats.dropped);
+        stats.latency.Dump("present latency");
+        if (placement) {
+            topology.Dump();
+        }
+    }
 #endif
 
     return 0;
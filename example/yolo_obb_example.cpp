@@ -0,0 +1,98 @@
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <unistd.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "yolo_obb.hpp"
+#include "label.hpp"
+#include "letterbox.hpp"
+
+
+std::string modelPath;
+std::string imagePath;
+Label label;
+float scoreThres = 0.25f;
+float nmsThres = 0.7f;
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 3) {
+        std::printf("Usage: %s <model> <image> [-l label] [-s scoreThres] [-n nmsThres]\r\n", argv[0]);
+        return -1;
+    }
+
+    modelPath.assign(argv[1]);
+    imagePath.assign(argv[2]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "l:s:n:")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 类别标签 */
+            case 'l':
+                label.Load(optarg);
+                std::printf("loaded %ld labels\r\n", label.size());
+                break;
+
+            /* 分数阈值 */
+            case 's':
+                scoreThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* NMS阈值 */
+            case 'n':
+                nmsThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* 加载模型 */
+    YoloObb model(modelPath, scoreThres, nmsThres);
+    auto inputSize = model.GetInputSize();
+
+    /* 加载图片，等比缩放保证旋转框的角度不因拉伸而失真 */
+    cv::Mat img = cv::imread(imagePath);
+    if (img.empty()) {
+        std::printf("read image %s failed\r\n", imagePath.c_str());
+        return -1;
+    }
+    std::printf("Read image %s\r\n", imagePath.c_str());
+    cv::Mat input;
+    Letterbox(img, inputSize, input);
+    cv::cvtColor(input, input, cv::COLOR_BGR2RGB);
+
+    /* 获取结果，映射回原图坐标 */
+    auto results = model.Predict(input.data, input.total() * input.elemSize());
+    Transformation trans({img.cols, img.rows}, inputSize);
+    std::printf("\r\n----- Got %ld objects -----\r\n", results->size());
+    for (auto &&result : *results) {
+        trans.ToOriginal(result.box);
+        std::printf("%s [%.2f, %.2f, %.2f, %.2f, %.1f deg] @ %.2f\r\n",
+                    label[result.id].c_str(),
+                    result.box.cx,
+                    result.box.cy,
+                    result.box.width,
+                    result.box.height,
+                    result.box.angle * 180.f / static_cast<float>(M_PI),
+                    result.score);
+    }
+
+    std::printf("preprocess: %ld us, inference: %ld us, postprocess: %ld us\r\n",
+                model.GetTimeCost().preprocess,
+                model.GetTimeCost().inference,
+                model.GetTimeCost().postprocess);
+    std::printf("rotated nms: %lu pairs, %lu polygon intersections\r\n",
+                model.GetNMSStats().pairs,
+                model.GetNMSStats().exact);
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "yolo_segment.hpp"
+#include "label.hpp"
+#include "rga.hpp"
+
+
+std::string modelPath;
+std::string imagePath;
+Label label;
+float scoreThres = 0.25f;
+float nmsThres = 0.7f;
+float maskThres = 0.5f;
+
+
+int main(int argc, char* argv[])
+{
+    /* 解析命令行参数 */
+    if (argc < 3) {
+        std::printf("Usage: %s <model> <image> [-l label] [-s scoreThres] [-n nmsThres] [-m maskThres]\r\n", argv[0]);
+        return -1;
+    }
+
+    modelPath.assign(argv[1]);
+    imagePath.assign(argv[2]);
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "l:s:n:m:")) != -1) {
+        switch (static_cast<char>(opt))
+        {
+            /* 类别标签 */
+            case 'l':
+                label.Load(optarg);
+                std::printf("loaded %ld labels\r\n", label.size());
+                break;
+
+            /* 分数阈值 */
+            case 's':
+                scoreThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* NMS阈值 */
+            case 'n':
+                nmsThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            /* 掩码阈值 */
+            case 'm':
+                maskThres = static_cast<float>(std::atof(optarg));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* 加载模型 */
+    YoloSegment model(modelPath, scoreThres, nmsThres, maskThres);
+    auto inputSize = model.GetInputSize();
+
+    /* 加载图片 */
+    cv::Mat img = cv::imread(imagePath);
+    std::printf("Read image %s\r\n", imagePath.c_str());
+    auto& input = rga->Run(
+        {
+            (void*) img.data,
+            Rga::Virtual,
+            {
+                img.cols,
+                img.rows,
+                RK_FORMAT_BGR_888
+            }
+        },
+        {
+            inputSize.width,
+            inputSize.height,
+            RK_FORMAT_RGB_888
+        }
+    );
+
+    /* 获取结果 */
+    auto results = model.Predict(input.addr, input.len);
+    std::printf("\r\n----- Got %ld objects -----\r\n", results->size());
+    for (auto &&result : *results) {
+        /* 统计掩码像素数 */
+        int pixels = 0;
+        for (int y = 0; y < result.mask.box.height; y++) {
+            for (int x = 0; x < result.mask.box.width; x++) {
+                pixels += result.mask.At(x, y);
+            }
+        }
+
+        std::printf("%s [%.2f, %.2f, %.2f, %.2f] @ %.2f, mask: %d pixels, %ld bytes\r\n",
+                    label[result.id].c_str(),
+                    result.box.x,
+                    result.box.y,
+                    result.box.width,
+                    result.box.height,
+                    result.score,
+                    pixels,
+                    result.mask.bits.size());
+    }
+
+    std::printf("preprocess: %ld us, inference: %ld us, postprocess: %ld us\r\n",
+                model.GetTimeCost().preprocess,
+                model.GetTimeCost().inference,
+                model.GetTimeCost().postprocess);
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "cascade.hpp"
+
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+
+Cascade::Cascade(const std::string& modelPath, const Config& config) :
+_config(config)
+{
+    _config.contexts = std::max(_config.contexts, 1);
+    for (int i = 0; i < _config.contexts; i++) {
+        _contexts.push_back(std::make_unique<Classify>(modelPath, _config.topk));
+    }
+    for (int i = 1; i < _config.contexts; i++) {
+        _workers.emplace_back(&Cascade::_Work, this, i);
+    }
+}
+
+Cascade::~Cascade()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+    for (auto &&worker : _workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void Cascade::Run(const uint8_t* frame, const Size& size, size_t stride, const DetectionBuffer& detections, std::vector<Item>& items)
+{
+    auto t1 = std::chrono::steady_clock::now();
+
+    /* 结果缓冲跨帧复用 */
+    items.resize(detections.Size());
+    _rois.clear();
+    _owners.clear();
+    for (size_t i = 0; i < detections.Size(); i++) {
+        items[i].detection = detections[i];
+        items[i].labels.Clear();
+
+        const Detection &det = items[i].detection;
+        if (!_config.classes.empty() &&
+            std::find(_config.classes.begin(), _config.classes.end(), det.id) == _config.classes.end()) {
+            continue;
+        }
+
+        /* 外扩后裁剪到原图范围内 */
+        float dx = det.box.width * _config.expand;
+        float dy = det.box.height * _config.expand;
+        int x0 = std::clamp(static_cast<int>(std::floor(det.box.x - dx)), 0, size.width);
+        int y0 = std::clamp(static_cast<int>(std::floor(det.box.y - dy)), 0, size.height);
+        int x1 = std::clamp(static_cast<int>(std::ceil(det.box.x + det.box.width + dx)), 0, size.width);
+        int y1 = std::clamp(static_cast<int>(std::ceil(det.box.y + det.box.height + dy)), 0, size.height);
+        if (x1 - x0 < _config.minSize || y1 - y0 < _config.minSize) {
+            continue;
+        }
+        _rois.emplace_back(x0, y0, x1 - x0, y1 - y0);
+        _owners.push_back(i);
+    }
+    if (_labels.size() < _rois.size()) {
+        _labels.resize(_rois.size());
+    }
+
+    if (!_rois.empty()) {
+        _frame = frame;
+        _stride = stride;
+
+        /* 唤醒其余上下文，调用线程执行第0份 */
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending = static_cast<int>(_workers.size());
+            _generation++;
+        }
+        _cond.notify_all();
+        _Classify(0);
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done.wait(lock, [this]() { return _pending == 0; });
+        }
+
+        /* 交换缓冲回填结果，两侧的内存均得以复用 */
+        for (size_t k = 0; k < _rois.size(); k++) {
+            std::swap(items[_owners[k]].labels, _labels[k]);
+        }
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.frames++;
+    _stats.crops += _rois.size();
+    _stats.cropCount.Add(static_cast<int64_t>(_rois.size()));
+    _stats.latency.Add(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+}
+
+Cascade::Stats Cascade::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+void Cascade::Dump() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::printf("cascade frames: %lu, crops: %lu, contexts: %d\r\n", _stats.frames, _stats.crops, _config.contexts);
+    _stats.cropCount.Dump("crops per frame", "");
+    _stats.latency.Dump("cascade latency");
+}
+
+void Cascade::_Work(int worker)
+{
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [&]() { return _stop || _generation != seen; });
+            if (_stop) {
+                break;
+            }
+            seen = _generation;
+        }
+
+        _Classify(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending--;
+        }
+        _done.notify_one();
+    }
+}
+
+void Cascade::_Classify(int worker)
+{
+    /* 按上下文均分连续的裁剪区域，每个上下文内部再按模型批大小分批 */
+    size_t n = _rois.size();
+    size_t begin = n * worker / _contexts.size();
+    size_t end = n * (worker + 1) / _contexts.size();
+    if (begin >= end) {
+        return;
+    }
+    _contexts[worker]->Predict(
+        _frame,
+        _stride,
+        std::span<const Rect>(_rois).subspan(begin, end - begin),
+        &_labels[begin],
+        _config.bgr
+    );
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "histogram.hpp"
+#include "yolo_detect.hpp"
+#include "classify.hpp"
+
+
+/* 检测-分类级联：检测框批量裁剪缩放后直接写入分类模型输入张量，多个分类上下文并行推理及后处理，结果回填到各检测框 */
+class Cascade
+{
+public:
+    struct Config
+    {
+        int contexts {1};  // 分类上下文数，各上下文在独立线程上并行推理
+        int topk {1};  // 每个检测框保留的分类结果数
+        std::vector<int> classes;  // 参与级联的检测类别，为空时全部参与
+        float expand {0.f};  // 检测框四周按宽高比例外扩后再裁剪
+        int minSize {8};  // 裁剪区域宽或高小于该值时不分类
+        bool bgr {true};  // 原图为BGR排布，写入输入张量时交换为RGB
+    };
+
+    struct Item
+    {
+        Detection detection;
+        ClassBuffer labels;  // 分类结果，未参与级联时为空
+    };
+
+    struct Stats
+    {
+        uint64_t frames {0};  // 处理帧数
+        uint64_t crops {0};  // 分类的区域总数
+        Histogram cropCount;  // 每帧裁剪数
+        Histogram latency;  // 每帧级联耗时(us)
+    };
+
+    Cascade(const std::string& modelPath, const Config& config);
+    ~Cascade();
+
+    /* frame为原图，stride为行字节数；detections为原图坐标，items与其一一对应并跨帧复用 */
+    void Run(const uint8_t* frame, const Size& size, size_t stride, const DetectionBuffer& detections, std::vector<Item>& items);
+
+    Stats GetStats() const;
+    void Dump() const;
+
+private:
+    Config _config;
+    std::vector<std::unique_ptr<Classify>> _contexts;
+    std::vector<std::thread> _workers;  // 第0个上下文在调用线程上执行，其余各占一个线程
+
+    /* 当前帧的裁剪任务，Run期间只读 */
+    const uint8_t* _frame {nullptr};
+    size_t _stride {0};
+    std::vector<Rect> _rois;
+    std::vector<size_t> _owners;  // 每个裁剪区域对应的检测框下标
+    std::vector<ClassBuffer> _labels;  // 与_rois一一对应，完成后与items交换
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cond;
+    std::condition_variable _done;
+    uint64_t _generation {0};  // 每帧递增，唤醒工作线程
+    int _pending {0};  // 未完成的工作线程数
+    bool _stop {false};
+    Stats _stats;
+
+    void _Work(int worker);
+    void _Classify(int worker);
+};
@@ -0,0 +1,160 @@
+#include "display_sink.hpp"
+
+
+DisplaySink::DisplaySink(Backend& backend, int rate, ThreadInit init) :
+_backend(backend),
+_period(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1. / rate))),
+_free(backend.GetFrameNum()),
+_ready(backend.GetFrameNum()),
+_submitTime(backend.GetFrameNum()),
+_init(std::move(init))
+{
+    for (int i = 0; i < backend.GetFrameNum(); i++) {
+        _free.Push(i);
+    }
+    _thread = std::thread(&DisplaySink::_Present, this);
+}
+
+DisplaySink::~DisplaySink()
+{
+    Stop();
+}
+
+int DisplaySink::Acquire()
+{
+    int index = -1;
+    return _free.Pop(index) ? index : -1;
+}
+
+void* DisplaySink::GetBuffer(int index)
+{
+    return _backend.GetFrame(index);
+}
+
+void DisplaySink::Submit(int index)
+{
+    _submitTime[index] = Clock::now();
+    _ready.Push(index);
+    _submitted++;
+}
+
+void DisplaySink::Stop()
+{
+    _stop = true;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+DisplaySink::Stats DisplaySink::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Stats stats = _stats;
+    stats.submitted = _submitted;
+    return stats;
+}
+
+void DisplaySink::_Present()
+{
+    if (_init) {
+        _init();
+    }
+
+    auto next = Clock::now();
+    while (!_stop) {
+        /* 休眠到下一个节拍，落后时从当前时刻重新对齐 */
+        next += _period;
+        if (next < Clock::now()) {
+            next = Clock::now();
+        }
+        std::this_thread::sleep_until(next);
+
+        /* 只保留最新的一帧，其余帧直接回收 */
+        int latest = -1;
+        int index = -1;
+        uint64_t dropped = 0;
+        while (_ready.Pop(index)) {
+            if (latest >= 0) {
+                _free.Push(latest);
+                dropped++;
+            }
+            latest = index;
+        }
+        if (latest < 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.dropped += dropped;
+            continue;
+        }
+
+        _backend.Present(latest);
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _submitTime[latest]);
+
+        /* 上一帧已不在屏幕上，可以复用 */
+        if (_shownIndex >= 0) {
+            _free.Push(_shownIndex);
+        }
+        _shownIndex = latest;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.shown++;
+        _stats.dropped += dropped;
+        _stats.latency.Add(latency.count());
+    }
+}
+
+
+NullDisplay::NullDisplay(int frameNum, size_t frameSize) :
+_frames(frameNum, std::vector<uint8_t>(frameSize))
+{
+
+}
+
+int NullDisplay::GetFrameNum() const
+{
+    return static_cast<int>(_frames.size());
+}
+
+void* NullDisplay::GetFrame(int index)
+{
+    return _frames[index].data();
+}
+
+void NullDisplay::Present(int index)
+{
+
+}
+
+
+FileDisplay::FileDisplay(const std::string& path, int frameNum, size_t frameSize) :
+_frames(frameNum, std::vector<uint8_t>(frameSize))
+{
+    _file = std::fopen(path.c_str(), "wb");
+    if (_file == nullptr) {
+        std::printf("open display file %s failed\r\n", path.c_str());
+    }
+}
+
+FileDisplay::~FileDisplay()
+{
+    if (_file) {
+        std::fclose(_file);
+        _file = nullptr;
+    }
+}
+
+int FileDisplay::GetFrameNum() const
+{
+    return static_cast<int>(_frames.size());
+}
+
+void* FileDisplay::GetFrame(int index)
+{
+    return _frames[index].data();
+}
+
+void FileDisplay::Present(int index)
+{
+    if (_file) {
+        std::fwrite(_frames[index].data(), 1, _frames[index].size(), _file);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "histogram.hpp"
+#include "spsc_queue.hpp"
+
+
+/* 预览输出，流水线写入环形帧缓冲后提交，显示线程按定时器节拍呈现最新帧并丢弃过期帧 */
+/* 节拍由sleep_until产生，不与屏幕垂直消隐同步，是否撕裂取决于后端的呈现方式 */
+class DisplaySink
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using ThreadInit = std::function<void()>;  // 显示线程启动时在该线程上调用，用于绑核等设置
+
+    /* 显示后端，持有若干帧缓冲 */
+    class Backend
+    {
+    public:
+        virtual ~Backend() = default;
+        virtual int GetFrameNum() const = 0;
+        virtual void* GetFrame(int index) = 0;
+        virtual void Present(int index) = 0;
+    };
+
+    struct Stats
+    {
+        uint64_t submitted {0};  // 提交帧数
+        uint64_t shown {0};  // 呈现帧数
+        uint64_t dropped {0};  // 被更新帧覆盖而未呈现的帧数
+        Histogram latency;  // 提交到呈现的延迟
+    };
+
+    explicit DisplaySink(Backend& backend, int rate = 60, ThreadInit init = nullptr);  // rate为呈现节拍(Hz)
+    ~DisplaySink();
+
+    int Acquire();
+    void* GetBuffer(int index);
+    void Submit(int index);
+    void Stop();
+    Stats GetStats() const;
+
+private:
+    Backend& _backend;
+    Clock::duration _period;
+    SpscQueue<int> _free;  // 空闲帧，显示线程生产，流水线消费
+    SpscQueue<int> _ready;  // 待呈现帧，流水线生产，显示线程消费
+    std::vector<Clock::time_point> _submitTime;
+    int _shownIndex {-1};  // 正在显示的帧，下次呈现前不可复用
+    ThreadInit _init;
+
+    std::thread _thread;
+    std::atomic<bool> _stop {false};
+    mutable std::mutex _mutex;
+    Stats _stats;
+    std::atomic<uint64_t> _submitted {0};
+
+    void _Present();
+};
+
+
+/* 空后端，用于无屏幕环境测试 */
+class NullDisplay : public DisplaySink::Backend
+{
+public:
+    NullDisplay(int frameNum, size_t frameSize);
+
+    int GetFrameNum() const override;
+    void* GetFrame(int index) override;
+    void Present(int index) override;
+
+private:
+    std::vector<std::vector<uint8_t>> _frames;
+};
+
+
+/* 文件后端，每次呈现时将整帧追加写入文件 */
+class FileDisplay : public DisplaySink::Backend
+{
+public:
+    FileDisplay(const std::string& path, int frameNum, size_t frameSize);
+    ~FileDisplay() override;
+
+    int GetFrameNum() const override;
+    void* GetFrame(int index) override;
+    void Present(int index) override;
+
+private:
+    std::FILE* _file {nullptr};
+    std::vector<std::vector<uint8_t>> _frames;
+};
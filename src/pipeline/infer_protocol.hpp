@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+
+
+/* 推理服务的二进制协议，客户端与服务端共用，所有字段为本机字节序 */
+/* 请求：Request | 图像数据；应答：Response | count个DetectRecord或ClassRecord */
+namespace InferProtocol
+{
+    constexpr uint32_t requestMagic = 0x51524b52;  // "RKRQ"
+    constexpr uint32_t responseMagic = 0x50524b52;  // "RKRP"
+    constexpr size_t modelNameSize = 32;
+    constexpr uint32_t maxPayload = 32 << 20;
+
+    enum Format : uint32_t
+    {
+        Raw = 0,  // RGB888原始像素，需填写宽高
+        Encoded = 1,  // JPEG/PNG等编码图像
+    };
+
+    enum Status : uint32_t
+    {
+        Ok = 0,
+        UnknownModel = 1,
+        BadImage = 2,
+        Busy = 3,  // 队列已满
+    };
+
+    enum Kind : uint32_t
+    {
+        Detect = 0,
+        Classify = 1,
+    };
+
+    struct Request
+    {
+        uint32_t magic;
+        uint32_t id;  // 由客户端分配，应答原样返回
+        char model[modelNameSize];
+        uint32_t format;
+        int32_t width;
+        int32_t height;
+        uint32_t length;  // 图像数据字节数
+    };
+
+    struct Response
+    {
+        uint32_t magic;
+        uint32_t id;
+        uint32_t status;
+        uint32_t kind;
+        uint32_t count;  // 结果条数
+        uint32_t latency;  // 服务端收到请求到发出应答的耗时(us)
+    };
+
+    /* 检测框为原图坐标 */
+    struct DetectRecord
+    {
+        int32_t id;
+        float score;
+        float x;
+        float y;
+        float width;
+        float height;
+    };
+
+    struct ClassRecord
+    {
+        int32_t id;
+        float score;
+    };
+
+    inline bool ReadAll(int fd, void* data, size_t len)
+    {
+        auto* p = static_cast<uint8_t*>(data);
+        while (len > 0) {
+            ssize_t n = read(fd, p, len);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    /* 对端已关闭时返回false并置errno为EPIPE，不产生SIGPIPE */
+    inline bool WriteAll(int fd, const void* data, size_t len)
+    {
+        auto* p = static_cast<const uint8_t*>(data);
+        while (len > 0) {
+            ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,372 @@
+#include "infer_server.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "letterbox.hpp"
+
+
+InferServer::InferServer(const std::string& socketPath) :
+InferServer(socketPath, Config())
+{
+
+}
+
+InferServer::InferServer(const std::string& socketPath, const Config& config) :
+_socketPath(socketPath), _config(config)
+{
+
+}
+
+InferServer::~InferServer()
+{
+    Stop();
+}
+
+bool InferServer::AddDetect(const std::string& name, const std::string& modelPath, int contexts, float scoreThres, float nmsThres)
+{
+    if (name.size() >= InferProtocol::modelNameSize || _listenFd >= 0) {
+        std::printf("can not add model %s\r\n", name.c_str());
+        return false;
+    }
+
+    auto model = std::make_unique<Model>();
+    model->name = name;
+    model->kind = InferProtocol::Detect;
+    for (int i = 0; i < contexts; i++) {
+        model->detect.push_back(std::make_unique<YoloDetect>(modelPath, scoreThres, nmsThres));
+    }
+    model->detectResults.resize(contexts);
+    _models.push_back(std::move(model));
+    return true;
+}
+
+bool InferServer::AddClassify(const std::string& name, const std::string& modelPath, int contexts, int topk)
+{
+    if (name.size() >= InferProtocol::modelNameSize || _listenFd >= 0) {
+        std::printf("can not add model %s\r\n", name.c_str());
+        return false;
+    }
+
+    auto model = std::make_unique<Model>();
+    model->name = name;
+    model->kind = InferProtocol::Classify;
+    for (int i = 0; i < contexts; i++) {
+        model->classify.push_back(std::make_unique<Classify>(modelPath, topk));
+    }
+    model->classifyResults.resize(contexts);
+    _models.push_back(std::move(model));
+    return true;
+}
+
+bool InferServer::Start()
+{
+    _listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_listenFd < 0) {
+        std::printf("create socket failed\r\n");
+        return false;
+    }
+
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, _socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(_socketPath.c_str());
+    if (bind(_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(_listenFd, 16) != 0) {
+        std::printf("listen on %s failed\r\n", _socketPath.c_str());
+        close(_listenFd);
+        _listenFd = -1;
+        return false;
+    }
+
+    /* 每个推理上下文一个线程 */
+    _stop = false;
+    for (auto& model : _models) {
+        size_t contexts = std::max(model->detect.size(), model->classify.size());
+        for (size_t i = 0; i < contexts; i++) {
+            _workers.emplace_back(&InferServer::_Work, this, model.get(), i);
+        }
+    }
+    _acceptThread = std::thread(&InferServer::_Accept, this);
+
+    return true;
+}
+
+void InferServer::Stop()
+{
+    if (_listenFd < 0) {
+        return;
+    }
+
+    _stop = true;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& model : _models) {
+            model->cond.notify_all();
+        }
+    }
+
+    if (_acceptThread.joinable()) {
+        _acceptThread.join();
+    }
+    for (auto& client : _clients) {
+        shutdown(client.conn->fd, SHUT_RDWR);
+        client.reader.join();
+    }
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+    _clients.clear();
+    _workers.clear();
+    for (auto& model : _models) {
+        model->queue.clear();
+    }
+
+    close(_listenFd);
+    _listenFd = -1;
+    unlink(_socketPath.c_str());
+}
+
+InferServer::Stats InferServer::GetStats(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& model : _models) {
+        if (model->name == name) {
+            return model->stats;
+        }
+    }
+    return {};
+}
+
+void InferServer::Dump() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& model : _models) {
+        auto& stats = model->stats;
+        std::printf("model %s: requests %lu, rejected %lu, abandoned %lu, batches %lu, pending %ld\r\n",
+                    model->name.c_str(),
+                    stats.requests,
+                    stats.rejected,
+                    stats.abandoned,
+                    stats.batches,
+                    model->queue.size());
+        stats.queueDepth.Dump("  queue depth", "");
+        stats.batchSize.Dump("  batch size", "");
+        stats.latency.Dump("  latency");
+    }
+}
+
+InferServer::Model* InferServer::_Find(const char* name)
+{
+    for (auto& model : _models) {
+        if (std::strncmp(model->name.c_str(), name, InferProtocol::modelNameSize) == 0) {
+            return model.get();
+        }
+    }
+    return nullptr;
+}
+
+void InferServer::_Accept()
+{
+    pollfd pfd {_listenFd, POLLIN, 0};
+    while (!_stop) {
+        /* 定期超时以便响应Stop */
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        int fd = accept(_listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+
+        /* 回收已断开的连接 */
+        for (auto it = _clients.begin(); it != _clients.end();) {
+            if (it->conn->closed) {
+                it->reader.join();
+                it = _clients.erase(it);
+            } else {
+                it++;
+            }
+        }
+
+        auto conn = std::make_shared<Connection>();
+        conn->fd = fd;
+        _clients.push_back({conn, std::thread(&InferServer::_Read, this, conn)});
+    }
+}
+
+void InferServer::_Read(std::shared_ptr<Connection> conn)
+{
+    while (!_stop) {
+        Request request;
+        if (!InferProtocol::ReadAll(conn->fd, &request.header, sizeof(request.header))) {
+            break;
+        }
+        if (request.header.magic != InferProtocol::requestMagic || request.header.length > InferProtocol::maxPayload) {
+            std::printf("invalid request, close connection\r\n");
+            break;
+        }
+        request.payload.resize(request.header.length);
+        if (!InferProtocol::ReadAll(conn->fd, request.payload.data(), request.payload.size())) {
+            break;
+        }
+        request.arrival = Clock::now();
+        request.conn = conn;
+
+        InferProtocol::Response response {InferProtocol::responseMagic, request.header.id, InferProtocol::Ok, 0, 0, 0};
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Model* model = _Find(request.header.model);
+            if (model == nullptr) {
+                response.status = InferProtocol::UnknownModel;
+            } else {
+                model->stats.requests++;
+                response.kind = model->kind;
+                if (model->queue.size() >= _config.queueDepth) {
+                    model->stats.rejected++;
+                    response.status = InferProtocol::Busy;
+                } else {
+                    model->queue.push_back(std::move(request));
+                    model->cond.notify_one();
+                    continue;
+                }
+            }
+        }
+        _Reply(*conn, response, nullptr, 0);
+    }
+
+    /* 对端关闭写端后不再读取，排队中的请求仍会被处理并应答 */
+    shutdown(conn->fd, SHUT_RD);
+    conn->closed = true;
+}
+
+void InferServer::_Work(Model* model, size_t context)
+{
+    std::vector<Request> batch;
+    batch.reserve(_config.maxBatch);
+    while (1) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            model->cond.wait(lock, [&] { return _stop || !model->queue.empty(); });
+            if (_stop) {
+                break;
+            }
+
+            /* 以首个请求到达时间为起点，在窗口内等待凑满一批 */
+            auto deadline = model->queue.front().arrival + std::chrono::microseconds(_config.window);
+            model->cond.wait_until(lock, deadline, [&] {
+                return _stop || model->queue.empty() || model->queue.size() >= _config.maxBatch;
+            });
+            if (_stop) {
+                break;
+            }
+            if (model->queue.empty()) {
+                /* 已被其他上下文取走 */
+                continue;
+            }
+
+            model->stats.queueDepth.Add(model->queue.size());
+            size_t n = std::min(model->queue.size(), _config.maxBatch);
+            for (size_t i = 0; i < n; i++) {
+                batch.push_back(std::move(model->queue.front()));
+                model->queue.pop_front();
+            }
+            model->stats.batches++;
+            model->stats.batchSize.Add(n);
+        }
+
+        /* 模型为单批输入，批内请求在本上下文上依次执行 */
+        for (auto& request : batch) {
+            _Process(model, context, request);
+        }
+        batch.clear();
+    }
+}
+
+void InferServer::_Process(Model* model, size_t context, Request& request)
+{
+    if (request.conn->broken) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        model->stats.abandoned++;
+        return;
+    }
+
+    InferProtocol::Response response {InferProtocol::responseMagic, request.header.id, InferProtocol::Ok, model->kind, 0, 0};
+
+    /* 解码图像 */
+    cv::Mat img;
+    if (request.header.format == InferProtocol::Encoded) {
+        img = cv::imdecode(request.payload, cv::IMREAD_COLOR);
+        if (!img.empty()) {
+            cv::cvtColor(img, img, cv::COLOR_BGR2RGB);
+        }
+    } else if (request.header.width > 0 && request.header.height > 0 &&
+               request.payload.size() == static_cast<size_t>(request.header.width) * request.header.height * 3) {
+        img = cv::Mat(request.header.height, request.header.width, CV_8UC3, request.payload.data());
+    }
+
+    if (img.empty()) {
+        response.status = InferProtocol::BadImage;
+        std::lock_guard<std::mutex> lock(_mutex);
+        model->stats.rejected++;
+    }
+
+    std::vector<uint8_t> records;
+    if (response.status == InferProtocol::Ok) {
+        Engine& engine = model->kind == InferProtocol::Detect ?
+                         static_cast<Engine&>(*model->detect[context]) :
+                         static_cast<Engine&>(*model->classify[context]);
+        Size inputSize = engine.GetInputSize();
+        cv::Mat input;
+        Letterbox(img, inputSize, input);
+        if (model->kind == InferProtocol::Detect) {
+            auto& results = model->detectResults[context];
+            Transformation trans({img.cols, img.rows}, inputSize);
+            model->detect[context]->Predict(input.data, input.total() * input.elemSize(), results, &trans);
+            records.resize(results.Size() * sizeof(InferProtocol::DetectRecord));
+            auto* rec = reinterpret_cast<InferProtocol::DetectRecord*>(records.data());
+            for (auto det : results) {
+                *rec++ = {det.id, det.score, det.box.x, det.box.y, det.box.width, det.box.height};
+            }
+            response.count = results.Size();
+        } else {
+            auto& results = model->classifyResults[context];
+            model->classify[context]->Predict(input.data, input.total() * input.elemSize(), results);
+            records.resize(results.Size() * sizeof(InferProtocol::ClassRecord));
+            auto* rec = reinterpret_cast<InferProtocol::ClassRecord*>(records.data());
+            for (size_t i = 0; i < results.Size(); i++) {
+                *rec++ = {static_cast<int32_t>(results.Ids()[i]), results.Scores()[i]};
+            }
+            response.count = results.Size();
+        }
+    }
+
+    int64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - request.arrival).count();
+    response.latency = static_cast<uint32_t>(latency);
+    _Reply(*request.conn, response, records.data(), records.size());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    model->stats.latency.Add(latency);
+}
+
+void InferServer::_Reply(Connection& conn, const InferProtocol::Response& response, const void* records, size_t len)
+{
+    std::lock_guard<std::mutex> lock(conn.mutex);
+    if (conn.broken) {
+        return;
+    }
+
+    /* 写入失败说明对端已断开，关闭连接使读线程退出，该连接排队中的请求不再处理 */
+    if (!InferProtocol::WriteAll(conn.fd, &response, sizeof(response)) ||
+        (len > 0 && !InferProtocol::WriteAll(conn.fd, records, len))) {
+        conn.broken = true;
+        shutdown(conn.fd, SHUT_RDWR);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include "infer_protocol.hpp"
+#include "histogram.hpp"
+#include "yolo_detect.hpp"
+#include "classify.hpp"
+
+
+/* Unix域套接字推理服务，多个应用共享一块NPU */
+/* 同一模型的并发请求在时间窗口内聚合成批，由该模型的上下文池并行消化 */
+class InferServer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config
+    {
+        int64_t window {2000};  // 聚合窗口(us)，收到首个请求后最多等待该时长凑批
+        size_t maxBatch {4};  // 单批最大请求数
+        size_t queueDepth {64};  // 每个模型的最大排队请求数，超出时返回Busy
+    };
+
+    struct Stats
+    {
+        uint64_t requests {0};  // 收到请求数
+        uint64_t rejected {0};  // 因队列满或解码失败被拒绝的请求数
+        uint64_t abandoned {0};  // 连接已断开而未执行的请求数
+        uint64_t batches {0};  // 执行批次数
+        Histogram queueDepth;  // 取批时的排队深度
+        Histogram batchSize;  // 每批请求数
+        Histogram latency;  // 收到请求到发出应答的延迟(us)
+    };
+
+    explicit InferServer(const std::string& socketPath);
+    InferServer(const std::string& socketPath, const Config& config);
+    ~InferServer();
+
+    bool AddDetect(const std::string& name, const std::string& modelPath, int contexts, float scoreThres = 0.25f, float nmsThres = 0.7f);
+    bool AddClassify(const std::string& name, const std::string& modelPath, int contexts, int topk = 5);
+
+    bool Start();
+    void Stop();
+
+    Stats GetStats(const std::string& name) const;
+    void Dump() const;
+
+private:
+    /* 排队中的请求持有连接引用，最后一个引用释放时关闭套接字 */
+    struct Connection
+    {
+        int fd {-1};
+        std::mutex mutex;  // 多个上下文线程可能同时向同一连接写应答
+        std::atomic<bool> closed {false};  // 读线程已退出
+        std::atomic<bool> broken {false};  // 应答写入失败，对端已断开
+
+        ~Connection()
+        {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    };
+
+    struct Client
+    {
+        std::shared_ptr<Connection> conn;
+        std::thread reader;
+    };
+
+    struct Request
+    {
+        std::shared_ptr<Connection> conn;
+        InferProtocol::Request header;
+        std::vector<uint8_t> payload;
+        Clock::time_point arrival;
+    };
+
+    struct Model
+    {
+        std::string name;
+        InferProtocol::Kind kind;
+        std::vector<std::unique_ptr<YoloDetect>> detect;
+        std::vector<std::unique_ptr<Classify>> classify;
+        std::vector<DetectionBuffer> detectResults;  // 每个上下文复用的结果缓冲
+        std::vector<ClassBuffer> classifyResults;
+        std::deque<Request> queue;
+        std::condition_variable cond;
+        Stats stats;
+    };
+
+    std::string _socketPath;
+    Config _config;
+    int _listenFd {-1};
+    std::vector<std::unique_ptr<Model>> _models;
+    std::thread _acceptThread;
+    std::vector<std::thread> _workers;
+    std::vector<Client> _clients;
+    mutable std::mutex _mutex;
+    std::atomic<bool> _stop {false};
+
+    Model* _Find(const char* name);
+    void _Accept();
+    void _Read(std::shared_ptr<Connection> conn);
+    void _Work(Model* model, size_t context);
+    void _Process(Model* model, size_t context, Request& request);
+    void _Reply(Connection& conn, const InferProtocol::Response& response, const void* records, size_t len);
+};
@@ -0,0 +1,43 @@
+#include "mpi_display.hpp"
+#include "rga.hpp"
+
+
+MpiDisplay::MpiDisplay(Display& display, int frameNum, const Size& size) :
+_display(display), _frameNum(frameNum), _size(size)
+{
+
+}
+
+int MpiDisplay::GetFrameNum() const
+{
+    return _frameNum;
+}
+
+void* MpiDisplay::GetFrame(int index)
+{
+    return _display.GetFrame(index + 1)->pData;
+}
+
+void MpiDisplay::Present(int index)
+{
+    rga->Run(
+        {
+            GetFrame(index),
+            Rga::Virtual,
+            {
+                _size.width,
+                _size.height,
+                RK_FORMAT_RGBA_8888
+            }
+        },
+        {
+            _display.GetFrame(0)->pData,
+            Rga::Virtual,
+            {
+                _size.width,
+                _size.height,
+                RK_FORMAT_RGBA_8888
+            }
+        }
+    );
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "types.hpp"
+#include "display.hpp"
+#include "display_sink.hpp"
+
+
+/* MPI屏幕后端，第0帧为扫描输出帧，其后frameNum帧作为环形缓冲，呈现时由RGA拷贝到输出帧 */
+/* 只有一个扫描输出帧，拷贝时该帧正在被扫描输出，画面变化较大时可能出现撕裂 */
+class MpiDisplay : public DisplaySink::Backend
+{
+public:
+    MpiDisplay(Display& display, int frameNum, const Size& size);
+
+    int GetFrameNum() const override;
+    void* GetFrame(int index) override;
+    void Present(int index) override;
+
+private:
+    Display& _display;
+    int _frameNum;
+    Size _size;
+};
@@ -0,0 +1,253 @@
+#include "result_ring.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+namespace ResultRing
+{
+    constexpr size_t headerSize = (sizeof(Header) + 63) / 64 * 64;  // 槽位按缓存行对齐
+
+    size_t SlotSize(uint32_t maxDetections)
+    {
+        size_t size = sizeof(SlotHeader) + maxDetections * (5 * sizeof(float) + sizeof(int32_t));
+        return (size + 63) / 64 * 64;  // 按缓存行对齐
+    }
+
+    /* 槽位内各数组的起始地址 */
+    template<typename T>
+    static inline T* Field(uint8_t* slot, uint32_t maxDetections, int index)
+    {
+        return reinterpret_cast<T*>(slot + sizeof(SlotHeader) + index * maxDetections * sizeof(float));
+    }
+};
+
+
+ResultPublisher::ResultPublisher(const std::string& name, uint32_t capacity, uint32_t maxDetections) :
+_name(name)
+{
+    if (capacity == 0) {
+        std::printf("result ring %s capacity must be positive\r\n", name.c_str());
+        return;
+    }
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        std::printf("open shared memory %s failed\r\n", name.c_str());
+        return;
+    }
+
+    size_t slotSize = ResultRing::SlotSize(maxDetections);
+    _size = ResultRing::headerSize + slotSize * capacity;
+    if (ftruncate(fd, _size) != 0) {
+        std::printf("resize shared memory %s failed\r\n", name.c_str());
+        close(fd);
+        return;
+    }
+
+    void* addr = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::printf("map shared memory %s failed\r\n", name.c_str());
+        return;
+    }
+    _base = static_cast<uint8_t*>(addr);
+    std::memset(_base, 0, _size);
+
+    /* magic最后写入，读进程据此判断缓冲区已初始化 */
+    _header = reinterpret_cast<ResultRing::Header*>(_base);
+    _header->version = ResultRing::version;
+    _header->capacity = capacity;
+    _header->maxDetections = maxDetections;
+    _header->slotSize = slotSize;
+    _header->written.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _header->magic = ResultRing::magic;
+}
+
+ResultPublisher::~ResultPublisher()
+{
+    if (_base) {
+        munmap(_base, _size);
+        _base = nullptr;
+        shm_unlink(_name.c_str());
+    }
+}
+
+bool ResultPublisher::IsOpen() const
+{
+    return _base != nullptr;
+}
+
+void ResultPublisher::Publish(uint64_t frameId, int64_t timestamp, const ResultRing::Columns& columns)
+{
+    if (!_base) {
+        return;
+    }
+
+    uint64_t n = _header->written.load(std::memory_order_relaxed);
+    uint32_t max = _header->maxDetections;
+    uint8_t* slot = _base + ResultRing::headerSize + (n % _header->capacity) * _header->slotSize;
+    auto* sh = reinterpret_cast<ResultRing::SlotHeader*>(slot);
+
+    /* 标记写入中 */
+    sh->seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t size = std::min({columns.classes.size(), columns.score.size(),
+                            columns.x.size(), columns.y.size(), columns.width.size(), columns.height.size()});
+    uint32_t count = static_cast<uint32_t>(std::min<size_t>(size, max));
+    sh->frameId = frameId;
+    sh->timestamp = timestamp;
+    sh->count = count;
+    float* x = ResultRing::Field<float>(slot, max, 0);
+    float* y = ResultRing::Field<float>(slot, max, 1);
+    float* w = ResultRing::Field<float>(slot, max, 2);
+    float* h = ResultRing::Field<float>(slot, max, 3);
+    float* score = ResultRing::Field<float>(slot, max, 4);
+    int32_t* cls = ResultRing::Field<int32_t>(slot, max, 5);
+    std::memcpy(x, columns.x.data(), count * sizeof(float));
+    std::memcpy(y, columns.y.data(), count * sizeof(float));
+    std::memcpy(w, columns.width.data(), count * sizeof(float));
+    std::memcpy(h, columns.height.data(), count * sizeof(float));
+    std::memcpy(score, columns.score.data(), count * sizeof(float));
+    std::memcpy(cls, columns.classes.data(), count * sizeof(int32_t));
+
+    /* 写入完成 */
+    sh->seq.store(2 * n + 2, std::memory_order_release);
+    _header->written.store(n + 1, std::memory_order_release);
+}
+
+
+ResultReader::ResultReader(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::printf("open shared memory %s failed\r\n", name.c_str());
+        return;
+    }
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < static_cast<off_t>(sizeof(ResultRing::Header))) {
+        std::printf("shared memory %s not initialized\r\n", name.c_str());
+        close(fd);
+        return;
+    }
+    _size = size;
+
+    void* addr = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::printf("map shared memory %s failed\r\n", name.c_str());
+        return;
+    }
+    _base = static_cast<const uint8_t*>(addr);
+    _header = reinterpret_cast<const ResultRing::Header*>(_base);
+    if (_header->magic != ResultRing::magic || _header->version != ResultRing::version) {
+        std::printf("shared memory %s has invalid header\r\n", name.c_str());
+        munmap(const_cast<uint8_t*>(_base), _size);
+        _base = nullptr;
+        _header = nullptr;
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    /* 残留或被重建的缓冲区头部可能与映射大小不符，越界的布局一律拒绝 */
+    _capacity = _header->capacity;
+    _maxDetections = _header->maxDetections;
+    _slotSize = _header->slotSize;
+    if (_capacity == 0 ||
+        _size < ResultRing::headerSize ||
+        _slotSize < ResultRing::SlotSize(_maxDetections) ||
+        _slotSize > (_size - ResultRing::headerSize) / _capacity) {
+        std::printf("shared memory %s has invalid layout: capacity %u, slot %lu, size %lu\r\n",
+                    name.c_str(), _capacity, _slotSize, _size);
+        munmap(const_cast<uint8_t*>(_base), _size);
+        _base = nullptr;
+        _header = nullptr;
+        return;
+    }
+
+    /* 从最新一帧开始读 */
+    _next = _header->written.load(std::memory_order_acquire);
+}
+
+ResultReader::~ResultReader()
+{
+    if (_base) {
+        munmap(const_cast<uint8_t*>(_base), _size);
+        _base = nullptr;
+    }
+}
+
+bool ResultReader::IsOpen() const
+{
+    return _base != nullptr;
+}
+
+bool ResultReader::Next(ResultRing::Frame& frame)
+{
+    if (!_base) {
+        return false;
+    }
+
+    uint64_t written = _header->written.load(std::memory_order_acquire);
+    uint32_t capacity = _capacity;
+    uint32_t max = _maxDetections;
+    while (_next < written) {
+        /* 落后超过一圈时跳到仍然有效的最旧帧 */
+        if (written - _next > capacity) {
+            _lost += written - capacity - _next;
+            _next = written - capacity;
+        }
+
+        const uint8_t* slot = _base + ResultRing::headerSize + (_next % capacity) * _slotSize;
+        auto* sh = reinterpret_cast<const ResultRing::SlotHeader*>(slot);
+        uint64_t seq = sh->seq.load(std::memory_order_acquire);
+        if (seq != 2 * _next + 2) {
+            /* 该槽位已被覆盖 */
+            _lost++;
+            _next++;
+            continue;
+        }
+
+        frame.frameId = sh->frameId;
+        frame.timestamp = sh->timestamp;
+        frame.count = std::min(sh->count, max);
+        uint8_t* s = const_cast<uint8_t*>(slot);
+        auto copy = [&](auto& dst, int index) {
+            using T = typename std::remove_reference_t<decltype(dst)>::value_type;
+            dst.resize(frame.count);
+            std::memcpy(dst.data(), ResultRing::Field<T>(s, max, index), frame.count * sizeof(T));
+        };
+        copy(frame.x, 0);
+        copy(frame.y, 1);
+        copy(frame.width, 2);
+        copy(frame.height, 3);
+        copy(frame.score, 4);
+        copy(frame.classes, 5);
+
+        /* 读取期间槽位未被改写才有效 */
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sh->seq.load(std::memory_order_relaxed) != seq) {
+            _lost++;
+            _next++;
+            written = _header->written.load(std::memory_order_acquire);
+            continue;
+        }
+
+        _next++;
+        return true;
+    }
+
+    return false;
+}
+
+uint64_t ResultReader::GetLost() const
+{
+    return _lost;
+}
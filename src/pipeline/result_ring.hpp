@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <span>
+#include <atomic>
+
+
+/* 基于POSIX共享内存的检测结果环形缓冲，一个写进程、任意多个读进程，无锁无序列化 */
+/* 内存布局：Header | Slot[capacity]，每个Slot为SlotHeader后接x/y/w/h/score/class六个定长数组 */
+namespace ResultRing
+{
+    constexpr uint32_t magic = 0x52524b52;  // "RKRR"
+    constexpr uint32_t version = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity;  // 槽位数
+        uint32_t maxDetections;  // 每帧最大目标数
+        uint64_t slotSize;  // 每个槽位字节数
+        alignas(64) std::atomic<uint64_t> written;  // 已写入帧数
+    };
+
+    /* seq为奇数时正在写入，写完后为 2 * (帧序号 + 1) */
+    struct SlotHeader
+    {
+        std::atomic<uint64_t> seq;
+        uint64_t frameId;
+        int64_t timestamp;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    struct Frame
+    {
+        uint64_t frameId {0};
+        int64_t timestamp {0};
+        uint32_t count {0};
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> width;
+        std::vector<float> height;
+        std::vector<float> score;
+        std::vector<int32_t> classes;
+    };
+
+    /* 写入一帧的各列，目标数取各列长度的最小值 */
+    struct Columns
+    {
+        std::span<const int32_t> classes;
+        std::span<const float> score;
+        std::span<const float> x;
+        std::span<const float> y;
+        std::span<const float> width;
+        std::span<const float> height;
+    };
+
+    size_t SlotSize(uint32_t maxDetections);
+};
+
+
+class ResultPublisher
+{
+public:
+    explicit ResultPublisher(const std::string& name, uint32_t capacity = 64, uint32_t maxDetections = 128);
+    ~ResultPublisher();
+
+    bool IsOpen() const;
+    void Publish(uint64_t frameId, int64_t timestamp, const ResultRing::Columns& columns);
+
+private:
+    std::string _name;
+    uint8_t* _base {nullptr};
+    size_t _size {0};
+    ResultRing::Header* _header {nullptr};
+};
+
+
+class ResultReader
+{
+public:
+    explicit ResultReader(const std::string& name);
+    ~ResultReader();
+
+    bool IsOpen() const;
+    bool Next(ResultRing::Frame& frame);
+    uint64_t GetLost() const;
+
+private:
+    const uint8_t* _base {nullptr};
+    size_t _size {0};
+    const ResultRing::Header* _header {nullptr};
+    uint32_t _capacity {0};  // 打开时校验过的布局，不再信任之后共享内存中的头部
+    uint32_t _maxDetections {0};
+    uint64_t _slotSize {0};
+    uint64_t _next {0};  // 下一个待读帧序号
+    uint64_t _lost {0};  // 被写进程覆盖而未读到的帧数
+};
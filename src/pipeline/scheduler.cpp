@@ -0,0 +1,225 @@
+#include "scheduler.hpp"
+
+#include <cstdio>
+#include <string>
+#include <algorithm>
+
+
+Scheduler::Scheduler(int workers, ThreadInit init) :
+_init(std::move(init)), _active(workers)
+{
+    for (int i = 0; i < workers; i++) {
+        _workers.emplace_back(&Scheduler::_Work, this, i);
+    }
+}
+
+Scheduler::~Scheduler()
+{
+    Stop();
+}
+
+int Scheduler::AddStream(const StreamConfig& config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _streams.emplace_back();
+    _streams.back().config = config;
+    _streams.back().vtime = _vclock;
+    return static_cast<int>(_streams.size()) - 1;
+}
+
+bool Scheduler::Submit(int stream, Job job)
+{
+    auto now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop || stream < 0 || stream >= static_cast<int>(_streams.size())) {
+            return false;
+        }
+
+        Stream &s = _streams[stream];
+        s.stats.submitted++;
+
+        /* 队列已满时丢弃最旧帧，保证处理的总是最新画面，新帧仍然入队 */
+        if (s.queue.size() >= s.config.depth) {
+            s.queue.pop_front();
+            s.stats.dropped++;
+            s.stats.evicted++;
+        }
+
+        /* 空闲后恢复的视频流不保留空闲期间的份额，从当前虚拟时间开始计数 */
+        if (s.queue.empty()) {
+            s.vtime = std::max(s.vtime, _vclock);
+            s.waiting = now;
+        }
+        s.queue.push_back({now, now + std::chrono::microseconds(s.config.slo), std::move(job)});
+    }
+    _cond.notify_one();
+
+    return true;
+}
+
+void Scheduler::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop) {
+            return;
+        }
+        _stop = true;
+    }
+    _cond.notify_all();
+
+    for (auto &worker : _workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    _workers.clear();
+}
+
+void Scheduler::SetActiveWorkers(int active)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _active = std::clamp(active, 1, static_cast<int>(_workers.size()));
+    }
+    _cond.notify_all();
+}
+
+size_t Scheduler::GetPending() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t pending = 0;
+    for (auto &s : _streams) {
+        pending += s.queue.size();
+    }
+    return pending;
+}
+
+int Scheduler::GetActiveWorkers() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _active;
+}
+
+Scheduler::StreamStats Scheduler::GetStats(int stream) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (stream < 0 || stream >= static_cast<int>(_streams.size())) {
+        return {};
+    }
+    return _streams[stream].stats;
+}
+
+void Scheduler::Dump() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < _streams.size(); i++) {
+        const StreamStats &stats = _streams[i].stats;
+        std::string tag = "stream " + std::to_string(i) +
+                          " (priority " + std::to_string(_streams[i].config.priority) +
+                          ", slo " + std::to_string(_streams[i].config.slo) + " us)" +
+                          " submitted " + std::to_string(stats.submitted) +
+                          ", completed " + std::to_string(stats.completed) +
+                          ", dropped " + std::to_string(stats.dropped) +
+                          " (evicted " + std::to_string(stats.evicted) + ")" +
+                          ", missed " + std::to_string(stats.missed) +
+                          ", latency";
+        stats.latency.Dump(tag.c_str());
+    }
+}
+
+void Scheduler::_Work(int worker)
+{
+    if (_init) {
+        _init(worker);
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        /* 等待可执行的帧 */
+        int stream = -1;
+        _cond.wait(lock, [&]() {
+            if (_stop) {
+                return true;
+            }
+            if (worker >= _active) {
+                return false;
+            }
+            stream = _Pick(Clock::now());
+            return stream >= 0;
+        });
+        if (_stop) {
+            break;
+        }
+
+        Frame frame = std::move(_streams[stream].queue.front());
+        _streams[stream].queue.pop_front();
+        _vclock = std::max(_vclock, _streams[stream].vtime);
+        _streams[stream].vtime++;
+        _streams[stream].waiting = Clock::now();
+
+        /* 执行推理时释放锁 */
+        lock.unlock();
+        auto start = Clock::now();
+        frame.job(worker);
+        auto end = Clock::now();
+        lock.lock();
+
+        Stream &s = _streams[stream];
+        int64_t cost = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        s.estimate = s.estimate == 0 ? cost : (s.estimate * 7 + cost) / 8;
+        s.stats.completed++;
+        s.stats.latency.Add(std::chrono::duration_cast<std::chrono::microseconds>(end - frame.arrival).count());
+        if (end > frame.deadline) {
+            s.stats.missed++;
+        }
+    }
+}
+
+int Scheduler::_Pick(Clock::time_point now)
+{
+    /* 有效优先级为配置的优先级加上等待分发时长对应的提升级数，不按队首帧计时，队列溢出换帧不会清零等待时长 */
+    auto priority = [now](const Stream &s) {
+        int64_t waited = std::chrono::duration_cast<std::chrono::microseconds>(now - s.waiting).count();
+        return s.config.priority + (s.config.aging > 0 ? static_cast<int>(waited / s.config.aging) : 0);
+    };
+
+    int best = -1;
+    int bestPriority = 0;
+    for (size_t i = 0; i < _streams.size(); i++) {
+        Stream &s = _streams[i];
+
+        /* 按当前耗时估计已无法在截止时间前完成的帧直接丢弃 */
+        while (!s.queue.empty() && now + std::chrono::microseconds(s.estimate) > s.queue.front().deadline) {
+            s.queue.pop_front();
+            s.stats.dropped++;
+        }
+        if (s.queue.empty()) {
+            continue;
+        }
+
+        /* 有效优先级高者优先，同优先级虚拟时间小者优先以保证各路公平，再相同时截止时间早者优先 */
+        int p = priority(s);
+        if (best < 0) {
+            best = static_cast<int>(i);
+            bestPriority = p;
+            continue;
+        }
+        const Stream &b = _streams[best];
+        bool better = false;
+        if (p != bestPriority) {
+            better = p > bestPriority;
+        } else if (s.vtime != b.vtime) {
+            better = s.vtime < b.vtime;
+        } else {
+            better = s.queue.front().deadline < b.queue.front().deadline;
+        }
+        if (better) {
+            best = static_cast<int>(i);
+            bestPriority = p;
+        }
+    }
+
+    return best;
+}
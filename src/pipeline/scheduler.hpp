@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "histogram.hpp"
+
+
+/* 多路视频流调度器，多路帧共享若干推理上下文，按优先级和截止时间分发，预计超时的帧直接丢弃 */
+/* 同优先级按起始时间公平排队(SFQ)轮转，低优先级视频流等待时逐级提升有效优先级，避免被高优先级饿死 */
+class Scheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Job = std::function<void(int worker)>;  // worker为执行该帧的上下文下标
+    using ThreadInit = std::function<void(int worker)>;  // 工作线程启动时在该线程上调用，用于绑核等设置
+
+    struct StreamConfig
+    {
+        int64_t slo {100000};  // 端到端延迟目标(us)
+        int priority {0};  // 优先级，越大越优先
+        size_t depth {2};  // 队列深度，满时丢弃最旧帧
+        int64_t aging {50000};  // 有帧待处理却未被分发的时长每达到该值，有效优先级提升一级(us)，不大于0时不提升
+    };
+
+    struct StreamStats
+    {
+        uint64_t submitted {0};  // 提交帧数
+        uint64_t completed {0};  // 完成帧数
+        uint64_t dropped {0};  // 队列溢出或预计超时被丢弃的帧数
+        uint64_t evicted {0};  // 其中因队列溢出被新帧挤出的帧数
+        uint64_t missed {0};  // 完成时已超过截止时间的帧数
+        Histogram latency;  // 提交到完成的延迟
+    };
+
+    explicit Scheduler(int workers, ThreadInit init = nullptr);
+    ~Scheduler();
+
+    int AddStream(const StreamConfig& config);
+    bool Submit(int stream, Job job);  // 返回新帧是否入队，被挤出的旧帧只计入统计
+    void Stop();
+    void SetActiveWorkers(int active);  // 只有下标小于active的上下文取帧，其余空闲
+
+    size_t GetPending() const;
+    int GetActiveWorkers() const;
+    StreamStats GetStats(int stream) const;
+    void Dump() const;
+
+private:
+    struct Frame
+    {
+        Clock::time_point arrival;
+        Clock::time_point deadline;
+        Job job;
+    };
+
+    struct Stream
+    {
+        StreamConfig config;
+        std::deque<Frame> queue;
+        StreamStats stats;
+        int64_t estimate {0};  // 执行耗时估计(us)，指数滑动平均
+        uint64_t vtime {0};  // 虚拟时间，每分发一帧加一，同优先级时小者优先
+        Clock::time_point waiting;  // 开始等待分发的时刻，入队时队列为空或分发后重置
+    };
+
+    std::vector<Stream> _streams;
+    std::vector<std::thread> _workers;
+    ThreadInit _init;
+    mutable std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _stop {false};
+    int _active {0};
+    uint64_t _vclock {0};  // 最近分发帧的虚拟时间，新加入或空闲后恢复的视频流从此处开始计数
+
+    void _Work(int worker);
+    int _Pick(Clock::time_point now);
+};
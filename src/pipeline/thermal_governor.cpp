@@ -0,0 +1,398 @@
+#include "thermal_governor.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <iterator>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+
+
+ThermalGovernor::ThermalGovernor(const std::vector<Step> &ladder, Apply apply) :
+ThermalGovernor(ladder, std::move(apply), Config())
+{
+
+}
+
+ThermalGovernor::ThermalGovernor(const std::vector<Step> &ladder, Apply apply, const Config &config) :
+_ladder(ladder), _apply(std::move(apply)), _config(config)
+{
+    if (_ladder.empty()) {
+        _ladder.push_back(Step());
+    }
+    _timeIn.assign(_ladder.size(), 0);
+    _start = Clock::now();
+    _lastChange = _start;
+    _FindZones();
+
+    /* debugfs通常需要root权限，缺失的传感器不参与判断 */
+    std::filesystem::path root(_config.root);
+    if (_ReadLoads((root / _config.loadPath).string()).empty()) {
+        std::printf("npu load not readable at %s\r\n", (root / _config.loadPath).c_str());
+    }
+    if (_ReadInt((root / _config.freqPath).string(), -1) < 0) {
+        std::printf("npu frequency not readable at %s\r\n", (root / _config.freqPath).c_str());
+    }
+
+    /* devfreq空闲时会降低cur_freq，只有max_freq低于硬件最高频率才是限频 */
+    _hwMaxFreq = _config.hwMaxFreq > 0 ? _config.hwMaxFreq : _ReadMaxOf((root / _config.availPath).string());
+    if (_hwMaxFreq <= 0) {
+        std::printf("npu available frequencies not readable at %s, throttle detection disabled\r\n",
+                    (root / _config.availPath).c_str());
+    }
+    if (_zonePaths.empty()) {
+        std::printf("no thermal zone found under %s\r\n", (root / _config.thermalPath).c_str());
+    }
+}
+
+ThermalGovernor::~ThermalGovernor()
+{
+    Stop();
+}
+
+std::vector<ThermalGovernor::Step> ThermalGovernor::MakeLadder(int contexts, int variants)
+{
+    contexts = std::max(contexts, 1);
+    variants = std::max(variants, 1);
+
+    /* 先换轻量模型，吞吐基本不变；再减少上下文，降低NPU并发；最后降低帧率 */
+    std::vector<Step> ladder;
+    for (int v = 0; v < variants; v++) {
+        ladder.push_back({1.0f, contexts, v});
+    }
+    for (int c = contexts - 1; c >= 1; c--) {
+        ladder.push_back({1.0f, c, variants - 1});
+    }
+    for (float fps : {0.75f, 0.5f}) {
+        ladder.push_back({fps, 1, variants - 1});
+    }
+    return ladder;
+}
+
+void ThermalGovernor::Start()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_stop) {
+        return;
+    }
+    _stop = false;
+    _thread = std::thread(&ThermalGovernor::_Loop, this);
+}
+
+void ThermalGovernor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+int ThermalGovernor::Update()
+{
+    Reading reading = _Sample();
+
+    Step step;
+    bool changed = false;
+    int level = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _samples++;
+
+        /* 最小二乘估计温升斜率 */
+        if (reading.temp >= 0) {
+            _temps.emplace_back(reading.time, reading.temp);
+            if (_temps.size() > _config.window) {
+                _temps.pop_front();
+            }
+        }
+        if (_temps.size() >= 2) {
+            double n = static_cast<double>(_temps.size());
+            double st = 0, sv = 0, stt = 0, stv = 0;
+            for (auto &[t, v] : _temps) {
+                double x = (t - _temps.front().first) / 1e6;
+                st += x;
+                sv += v;
+                stt += x * x;
+                stv += x * v;
+            }
+            double den = n * stt - st * st;
+            reading.slope = den > 0 ? static_cast<float>((n * stv - st * sv) / den) : 0.0f;
+        }
+        _reading = reading;
+
+        float predicted = reading.temp + std::max(reading.slope, 0.0f) * (_config.horizon / 1e6f);
+        bool hot = reading.temp >= 0 && reading.temp >= _config.tempHigh;
+        bool rising = reading.temp >= 0 && predicted >= _config.tempHigh;
+        bool warm = reading.temp >= 0 && reading.temp >= _config.tempLow;
+        bool busy = reading.load >= _config.loadHigh;
+        bool throttled = warm && reading.maxFreq > 0 && reading.hwMaxFreq > 0 &&
+                         reading.maxFreq < reading.hwMaxFreq * static_cast<double>(_config.freqRatio);
+        int64_t since = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _lastChange).count();
+        int top = static_cast<int>(_ladder.size()) - 1;
+        int from = _level;
+
+        /* 每次变化后需停留足够时间，避免档位抖动；限频要求温度高于tempLow，与恢复条件互斥 */
+        if (since >= _config.dwell) {
+            if (throttled && _level < top) {
+                _Change(_level + 1, "throttled");
+            } else if (hot && _level < top) {
+                _Change(_level + 1, "temperature");
+            } else if (rising && _level < top) {
+                _Change(_level + 1, "trend");
+            } else if (busy && warm && _level < top) {
+                _Change(_level + 1, "load");
+            } else if (reading.temp >= 0 && !warm && predicted < _config.tempLow && !busy && _level > 0) {
+                _Change(_level - 1, "recovered");
+            }
+        }
+
+        level = _level;
+        changed = _level != from;
+        step = _ladder[_level];
+    }
+
+    /* 回调可能调整调度器或切换模型，不持锁调用 */
+    if (changed && _apply) {
+        _apply(step);
+    }
+    return level;
+}
+
+int ThermalGovernor::GetLevel() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _level;
+}
+
+ThermalGovernor::Step ThermalGovernor::GetStep() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _ladder[_level];
+}
+
+ThermalGovernor::Reading ThermalGovernor::GetReading() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _reading;
+}
+
+std::vector<ThermalGovernor::Event> ThermalGovernor::GetEvents() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _events;
+}
+
+std::vector<int64_t> ThermalGovernor::GetTimeInLevel() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<int64_t> timeIn = _timeIn;
+    timeIn[_level] += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _lastChange).count();
+    return timeIn;
+}
+
+bool ThermalGovernor::Export(const std::string &path) const
+{
+    auto timeIn = GetTimeInLevel();
+    std::ostringstream oss;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const Reading &r = _reading;
+        const Step &step = _ladder[_level];
+
+        oss << "# TYPE rknn_npu_load gauge\n";
+        for (size_t i = 0; i < r.loads.size(); i++) {
+            oss << "rknn_npu_load{core=\"" << i << "\"} " << r.loads[i] << "\n";
+        }
+        oss << "# TYPE rknn_npu_freq_hz gauge\n";
+        oss << "rknn_npu_freq_hz " << r.freq << "\n";
+        oss << "# TYPE rknn_npu_max_freq_hz gauge\n";
+        oss << "rknn_npu_max_freq_hz " << r.maxFreq << "\n";
+        oss << "# TYPE rknn_npu_hw_max_freq_hz gauge\n";
+        oss << "rknn_npu_hw_max_freq_hz " << r.hwMaxFreq << "\n";
+        oss << "# TYPE rknn_soc_temp_celsius gauge\n";
+        oss << "rknn_soc_temp_celsius " << r.temp << "\n";
+        oss << "# TYPE rknn_soc_temp_slope gauge\n";
+        oss << "rknn_soc_temp_slope " << r.slope << "\n";
+        oss << "# TYPE rknn_governor_level gauge\n";
+        oss << "rknn_governor_level " << _level << "\n";
+        oss << "# TYPE rknn_governor_fps_ratio gauge\n";
+        oss << "rknn_governor_fps_ratio " << step.fps << "\n";
+        oss << "# TYPE rknn_governor_contexts gauge\n";
+        oss << "rknn_governor_contexts " << step.contexts << "\n";
+        oss << "# TYPE rknn_governor_variant gauge\n";
+        oss << "rknn_governor_variant " << step.variant << "\n";
+        oss << "# TYPE rknn_governor_samples_total counter\n";
+        oss << "rknn_governor_samples_total " << _samples << "\n";
+        oss << "# TYPE rknn_governor_changes_total counter\n";
+        oss << "rknn_governor_changes_total " << _events.size() << "\n";
+    }
+    oss << "# TYPE rknn_governor_level_seconds counter\n";
+    for (size_t i = 0; i < timeIn.size(); i++) {
+        oss << "rknn_governor_level_seconds{level=\"" << i << "\"} " << timeIn[i] / 1e6 << "\n";
+    }
+
+    /* 先写临时文件再改名，采集端不会读到写了一半的文件 */
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::trunc);
+        if (!ofs.good()) {
+            std::printf("open %s failed\r\n", tmp.c_str());
+            return false;
+        }
+        ofs << oss.str();
+        if (!ofs.good()) {
+            std::printf("write %s failed\r\n", tmp.c_str());
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::printf("rename %s failed: %s\r\n", path.c_str(), ec.message().c_str());
+        return false;
+    }
+    return true;
+}
+
+void ThermalGovernor::Dump() const
+{
+    auto timeIn = GetTimeInLevel();
+    auto events = GetEvents();
+    Reading r = GetReading();
+
+    std::printf("npu load: %.0f%%, freq: %ld/%ld/%ld Hz, temp: %.1f C (%+.2f C/s)\r\n",
+                r.load, r.freq, r.maxFreq, r.hwMaxFreq, r.temp, r.slope);
+    std::printf("governor changes: %ld\r\n", events.size());
+    for (auto &e : events) {
+        std::printf("  %.3f s: %d -> %d (%s), load: %.0f%%, freq: %ld/%ld Hz, temp: %.1f C (%+.2f C/s)\r\n",
+                    e.time / 1e6, e.from, e.to, e.reason,
+                    e.reading.load, e.reading.freq, e.reading.maxFreq, e.reading.temp, e.reading.slope);
+    }
+    for (size_t i = 0; i < _ladder.size(); i++) {
+        std::printf("  level %ld (fps x%.2f, contexts %d, variant %d): %.3f s\r\n",
+                    i, _ladder[i].fps, _ladder[i].contexts, _ladder[i].variant, timeIn[i] / 1e6);
+    }
+}
+
+void ThermalGovernor::_Loop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop) {
+        lock.unlock();
+        Update();
+        lock.lock();
+        _cond.wait_for(lock, std::chrono::microseconds(_config.period), [this]() { return _stop; });
+    }
+}
+
+void ThermalGovernor::_FindZones()
+{
+    /* 枚举thermal_zoneN目录，按type筛选 */
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::path(_config.root) / _config.thermalPath;
+    for (auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, 12, "thermal_zone") != 0) {
+            continue;
+        }
+
+        std::string type;
+        std::ifstream ifs(entry.path() / "type");
+        ifs >> type;
+        if (_config.zones.empty() ||
+            std::find(_config.zones.begin(), _config.zones.end(), type) != _config.zones.end()) {
+            _zonePaths.push_back((entry.path() / "temp").string());
+        }
+    }
+    std::sort(_zonePaths.begin(), _zonePaths.end());
+}
+
+ThermalGovernor::Reading ThermalGovernor::_Sample()
+{
+    std::filesystem::path root(_config.root);
+    Reading reading;
+    reading.time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _start).count();
+
+    reading.loads = _ReadLoads((root / _config.loadPath).string());
+    for (float load : reading.loads) {
+        reading.load = std::max(reading.load, load);
+    }
+    reading.freq = _ReadInt((root / _config.freqPath).string(), -1);
+    reading.maxFreq = _ReadInt((root / _config.maxFreqPath).string(), -1);
+    reading.hwMaxFreq = _hwMaxFreq;
+
+    /* 温度单位为毫摄氏度 */
+    for (auto &path : _zonePaths) {
+        int64_t temp = _ReadInt(path, INT64_MIN);
+        if (temp != INT64_MIN) {
+            reading.temp = std::max(reading.temp, temp / 1000.0f);
+        }
+    }
+    return reading;
+}
+
+void ThermalGovernor::_Change(int to, const char* reason)
+{
+    auto now = Clock::now();
+    Event event;
+    event.time = std::chrono::duration_cast<std::chrono::microseconds>(now - _start).count();
+    event.from = _level;
+    event.to = to;
+    event.reason = reason;
+    event.reading = _reading;
+    _events.push_back(event);
+
+    _timeIn[_level] += std::chrono::duration_cast<std::chrono::microseconds>(now - _lastChange).count();
+    _level = to;
+    _lastChange = now;
+}
+
+int64_t ThermalGovernor::_ReadInt(const std::string &path, int64_t def)
+{
+    std::ifstream ifs(path);
+    int64_t value = def;
+    if (!(ifs >> value)) {
+        return def;
+    }
+    return value;
+}
+
+std::vector<float> ThermalGovernor::_ReadLoads(const std::string &path)
+{
+    /* 格式为 "NPU load:  Core0: 45%, Core1: 12%, Core2:  0%,"，单核平台为 "NPU load: 45%" */
+    std::ifstream ifs(path);
+    std::string text((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    std::vector<float> loads;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] != '%') {
+            continue;
+        }
+        size_t begin = i;
+        while (begin > 0 && (std::isdigit(static_cast<unsigned char>(text[begin - 1])) || text[begin - 1] == '.')) {
+            begin--;
+        }
+        if (begin < i) {
+            loads.push_back(std::strtof(text.c_str() + begin, nullptr));
+        }
+    }
+    return loads;
+}
+
+int64_t ThermalGovernor::_ReadMaxOf(const std::string &path)
+{
+    /* 格式为空格分隔的频率列表，如 "300000000 400000000 ... 1000000000" */
+    std::ifstream ifs(path);
+    int64_t value = 0;
+    int64_t max = -1;
+    while (ifs >> value) {
+        max = std::max(max, value);
+    }
+    return max;
+}
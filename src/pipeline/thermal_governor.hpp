@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+
+/* 按NPU负载、NPU频率及SoC温度提前降档，在内核硬降频之前主动降低帧率、上下文数或切换轻量模型 */
+/* 传感器从sysfs/debugfs读取，root可指向伪造的目录以便在无目标板的环境验证 */
+class ThermalGovernor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /* 一个档位，档位越高负载越轻 */
+    struct Step
+    {
+        float fps {1.0f};  // 目标帧率相对满帧率的比例
+        int contexts {1};  // 活跃上下文数
+        int variant {0};  // 模型规格下标，按由重到轻排列
+    };
+
+    using Apply = std::function<void(const Step& step)>;  // 档位变化时在采样线程上调用
+
+    struct Config
+    {
+        std::string root {"/"};
+        std::string loadPath {"sys/kernel/debug/rknpu/load"};
+        std::string freqPath {"sys/class/devfreq/fdab0000.npu/cur_freq"};
+        std::string maxFreqPath {"sys/class/devfreq/fdab0000.npu/max_freq"};
+        std::string availPath {"sys/class/devfreq/fdab0000.npu/available_frequencies"};
+        int64_t hwMaxFreq {0};  // 硬件最高频率(Hz)，为0时取available_frequencies的最大项
+        std::string thermalPath {"sys/class/thermal"};
+        std::vector<std::string> zones {"soc-thermal", "npu-thermal"};  // 参与判断的温区类型，为空时取所有温区
+
+        int64_t period {500000};  // 采样周期(us)
+        float tempHigh {80.0f};  // 温度或预测温度超过该值时降档(℃)
+        float tempLow {70.0f};  // 温度低于该值且负载有余量时升档(℃)
+        int64_t horizon {5000000};  // 按温升斜率预测该时长后的温度(us)
+        size_t window {10};  // 温升斜率的采样窗口
+        float loadHigh {90.0f};  // 负载超过该值且温度已高于tempLow时降档(%)
+        float freqRatio {0.95f};  // 温度高于tempLow且频率上限低于硬件最高频率该比例时视为内核已限频，降档
+        int64_t dwell {3000000};  // 档位变化后最短停留时间(us)
+    };
+
+    struct Reading
+    {
+        int64_t time {0};  // 距启动的时间(us)
+        std::vector<float> loads;  // 各NPU核负载(%)，不可读时为空
+        float load {-1.0f};  // 各核最高负载(%)
+        int64_t freq {-1};  // 当前NPU频率(Hz)
+        int64_t maxFreq {-1};  // 当前NPU频率上限(Hz)，含温控限频
+        int64_t hwMaxFreq {-1};  // 硬件最高NPU频率(Hz)
+        float temp {-1.0f};  // 所选温区最高温度(℃)
+        float slope {0.0f};  // 温升斜率(℃/s)
+    };
+
+    struct Event
+    {
+        int64_t time {0};  // 距启动的时间(us)
+        int from {0};
+        int to {0};
+        const char* reason {""};
+        Reading reading;
+    };
+
+    ThermalGovernor(const std::vector<Step> &ladder, Apply apply);
+    ThermalGovernor(const std::vector<Step> &ladder, Apply apply, const Config &config);
+    ~ThermalGovernor();
+
+    /* 由满帧率、上下文数及模型规格数生成默认档位，依次切换轻量模型、减少上下文、降低帧率 */
+    static std::vector<Step> MakeLadder(int contexts, int variants);
+
+    void Start();
+    void Stop();
+    int Update();  // 采样一次并决策，返回当前档位
+
+    int GetLevel() const;
+    Step GetStep() const;
+    Reading GetReading() const;
+    std::vector<Event> GetEvents() const;
+    std::vector<int64_t> GetTimeInLevel() const;
+
+    bool Export(const std::string &path) const;  // 以Prometheus文本格式导出
+    void Dump() const;
+
+private:
+    std::vector<Step> _ladder;
+    Apply _apply;
+    Config _config;
+    std::vector<std::string> _zonePaths;  // 所选温区的temp文件
+    int64_t _hwMaxFreq {-1};
+
+    mutable std::mutex _mutex;
+    int _level {0};
+    Reading _reading;
+    std::deque<std::pair<int64_t, float>> _temps;  // 最近若干次采样的时间及温度
+    Clock::time_point _start;
+    Clock::time_point _lastChange;
+    std::vector<int64_t> _timeIn;  // 各档位累计停留时间(us)，不含当前档位本次停留
+    std::vector<Event> _events;
+    uint64_t _samples {0};
+
+    std::thread _thread;
+    std::condition_variable _cond;
+    bool _stop {true};
+
+    void _Loop();
+    void _FindZones();
+    Reading _Sample();
+    void _Change(int to, const char* reason);
+
+    static int64_t _ReadInt(const std::string &path, int64_t def);
+    static std::vector<float> _ReadLoads(const std::string &path);
+    static int64_t _ReadMaxOf(const std::string &path);
+};
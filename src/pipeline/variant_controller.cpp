@@ -0,0 +1,145 @@
+#include "variant_controller.hpp"
+
+#include <cstdio>
+#include <algorithm>
+
+
+VariantController::VariantController(const std::vector<std::string> &modelPaths, float scoreThres, float nmsThres) :
+VariantController(modelPaths, scoreThres, nmsThres, Config())
+{
+
+}
+
+VariantController::VariantController(
+    const std::vector<std::string> &modelPaths,
+    float scoreThres,
+    float nmsThres,
+    const Config &config) :
+_paths(modelPaths), _config(config)
+{
+    for (auto &path : modelPaths) {
+        _models.push_back(std::make_unique<YoloDetect>(path, scoreThres, nmsThres));
+    }
+    _timeIn.assign(_models.size(), 0);
+    _start = Clock::now();
+    _lastSwitch = _start;
+}
+
+YoloDetect::ResultPtr VariantController::Predict(const void* data, size_t len)
+{
+    return Current().Predict(data, len);
+}
+
+void VariantController::Report(int64_t latency, size_t queue)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _window.push_back(latency);
+    _windowSum += latency;
+    if (_window.size() > _config.window) {
+        _windowSum -= _window.front();
+        _window.pop_front();
+    }
+
+    /* 窗口未填满或停留时间不足时不切换，避免频繁抖动 */
+    auto now = Clock::now();
+    if (_window.size() < _config.window ||
+        std::chrono::duration_cast<std::chrono::microseconds>(now - _lastSwitch).count() < _config.dwell) {
+        return;
+    }
+
+    int64_t mean = _windowSum / static_cast<int64_t>(_window.size());
+    if ((mean > _config.budget * _config.downRatio || queue > _config.queueHigh) &&
+        _current + 1 < static_cast<int>(_models.size())) {
+        _Switch(_current + 1, queue);
+    } else if (mean < _config.budget * _config.upRatio && queue == 0 && _current > _floor) {
+        _Switch(_current - 1, queue);
+    }
+}
+
+void VariantController::Select(int index)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (index < 0 || index >= static_cast<int>(_models.size())) {
+        return;
+    }
+
+    /* 先按下限修正目标，与当前规格相同时不记录切换，也不重置停留计时 */
+    int target = std::max(index, _floor);
+    if (target != _current) {
+        _Switch(target, 0);
+    }
+}
+
+void VariantController::SetFloor(int index)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _floor = std::clamp(index, 0, static_cast<int>(_models.size()) - 1);
+    if (_current < _floor) {
+        _Switch(_floor, 0);
+    }
+}
+
+YoloDetect& VariantController::Current()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return *_models[_current];
+}
+
+int VariantController::GetCurrentIndex() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _current;
+}
+
+size_t VariantController::GetVariantNum() const
+{
+    return _models.size();
+}
+
+std::vector<VariantController::SwitchEvent> VariantController::GetSwitchEvents() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _events;
+}
+
+std::vector<int64_t> VariantController::GetTimeInVariant() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<int64_t> timeIn = _timeIn;
+    timeIn[_current] += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _lastSwitch).count();
+    return timeIn;
+}
+
+void VariantController::Dump() const
+{
+    auto timeIn = GetTimeInVariant();
+    auto events = GetSwitchEvents();
+
+    std::printf("variant switches: %ld\r\n", events.size());
+    for (auto &e : events) {
+        std::printf("  %.3f s: %d -> %d, latency: %ld us, queue: %ld\r\n",
+                    e.time / 1e6, e.from, e.to, e.latency, e.queue);
+    }
+    for (size_t i = 0; i < _paths.size(); i++) {
+        std::printf("  variant %ld %s: %.3f s\r\n", i, _paths[i].c_str(), timeIn[i] / 1e6);
+    }
+}
+
+void VariantController::_Switch(int to, size_t queue)
+{
+    auto now = Clock::now();
+    SwitchEvent event;
+    event.time = std::chrono::duration_cast<std::chrono::microseconds>(now - _start).count();
+    event.from = _current;
+    event.to = to;
+    event.latency = _window.empty() ? 0 : _windowSum / static_cast<int64_t>(_window.size());
+    event.queue = queue;
+    _events.push_back(event);
+
+    _timeIn[_current] += std::chrono::duration_cast<std::chrono::microseconds>(now - _lastSwitch).count();
+    _current = to;
+    _lastSwitch = now;
+    _window.clear();
+    _windowSum = 0;
+}
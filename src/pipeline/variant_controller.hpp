@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+#include "yolo_detect.hpp"
+
+
+/* 同一检测器多个规格(n/s/m等)间按实测延迟和队列深度自动切换，负载高时降级，余量恢复后升级 */
+class VariantController
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config
+    {
+        int64_t budget {33000};  // 端到端延迟预算(us)
+        float downRatio {0.9f};  // 窗口平均延迟超过预算该比例时降级
+        float upRatio {0.6f};  // 窗口平均延迟低于预算该比例且队列为空时升级
+        size_t queueHigh {2};  // 队列深度超过该值时降级
+        size_t window {30};  // 滑动窗口帧数，切换后需重新填满才会再次切换
+        int64_t dwell {2000000};  // 切换后最短停留时间(us)
+    };
+
+    struct SwitchEvent
+    {
+        int64_t time {0};  // 距启动的时间(us)
+        int from {0};
+        int to {0};
+        int64_t latency {0};  // 切换时窗口平均延迟(us)
+        size_t queue {0};  // 切换时队列深度
+    };
+
+    /* modelPaths按由重到轻排列 */
+    explicit VariantController(const std::vector<std::string> &modelPaths,
+                               float scoreThres = 0.25f,
+                               float nmsThres = 0.7f);
+    VariantController(const std::vector<std::string> &modelPaths,
+                      float scoreThres,
+                      float nmsThres,
+                      const Config &config);
+
+    YoloDetect::ResultPtr Predict(const void* data, size_t len);
+    void Report(int64_t latency, size_t queue);
+    void Select(int index);
+    void SetFloor(int index);  // 限制只使用不重于该下标的规格，如温控降档时
+
+    YoloDetect& Current();
+    int GetCurrentIndex() const;
+    size_t GetVariantNum() const;
+    std::vector<SwitchEvent> GetSwitchEvents() const;
+    std::vector<int64_t> GetTimeInVariant() const;
+    void Dump() const;
+
+private:
+    std::vector<std::unique_ptr<YoloDetect>> _models;
+    std::vector<std::string> _paths;
+    Config _config;
+
+    mutable std::mutex _mutex;
+    int _current {0};
+    int _floor {0};
+    std::deque<int64_t> _window;  // 最近若干帧延迟
+    int64_t _windowSum {0};
+    Clock::time_point _start;
+    Clock::time_point _lastSwitch;
+    std::vector<int64_t> _timeIn;  // 各规格累计运行时间(us)，不含当前规格本次停留
+    std::vector<SwitchEvent> _events;
+
+    void _Switch(int to, size_t queue);
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <functional>
+#include <coroutine>
+
+#include "async_worker.hpp"
+
+
+/* 异步推理结果，既可像future一样阻塞获取，也可在协程中co_await */
+/* 协程不在引擎的执行线程上恢复，否则协程内再次提交到同一引擎或析构引擎会自锁 */
+/* 默认在公共的完成线程上恢复，通过Via指定执行器后改由执行器恢复，如事件循环线程 */
+template<typename T>
+class AsyncResult
+{
+public:
+    using Executor = std::function<void(std::function<void()>)>;
+
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::optional<T> value;
+        std::coroutine_handle<> waiter;
+        Executor executor;
+
+        void Set(T value_)
+        {
+            std::coroutine_handle<> handle;
+            Executor exec;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                value.emplace(std::move(value_));
+                handle = waiter;
+                exec = executor;
+            }
+            cond.notify_all();
+
+            if (handle) {
+                if (exec) {
+                    exec([handle]() { handle.resume(); });
+                } else {
+                    /* 进程退出时完成线程已停止，挂起的协程不再恢复 */
+                    AsyncWorker::Completion().Submit([handle](bool run) {
+                        if (run) {
+                            handle.resume();
+                        }
+                    });
+                }
+            }
+        }
+    };
+
+    AsyncResult() : _state(std::make_shared<State>()) {}
+
+    const std::shared_ptr<State>& GetState() const { return _state; }
+
+    AsyncResult Via(Executor executor) const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        _state->executor = std::move(executor);
+        return *this;
+    }
+
+    bool Ready() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return _state->value.has_value();
+    }
+
+    void Wait() const
+    {
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        _state->cond.wait(lock, [this]() { return _state->value.has_value(); });
+    }
+
+    /* 阻塞直到完成，结果只能取出一次 */
+    T Get()
+    {
+        Wait();
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return std::move(*_state->value);
+    }
+
+    bool await_ready() const
+    {
+        return Ready();
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        /* 加锁期间结果已就绪时不挂起，避免错过唤醒 */
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        if (_state->value.has_value()) {
+            return false;
+        }
+        _state->waiter = handle;
+        return true;
+    }
+
+    T await_resume()
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return std::move(*_state->value);
+    }
+
+private:
+    std::shared_ptr<State> _state;
+};
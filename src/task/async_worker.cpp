@@ -0,0 +1,75 @@
+#include "async_worker.hpp"
+
+
+AsyncWorker::AsyncWorker()
+{
+    _thread = std::thread(&AsyncWorker::_Loop, this);
+}
+
+AsyncWorker::~AsyncWorker()
+{
+    Stop();
+}
+
+void AsyncWorker::Submit(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_stop) {
+            _jobs.push_back(std::move(job));
+            job = nullptr;
+        }
+    }
+
+    /* 已停止时立即以空结果完成 */
+    if (job) {
+        job(false);
+        return;
+    }
+    _cond.notify_one();
+}
+
+void AsyncWorker::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_one();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+AsyncWorker& AsyncWorker::Completion()
+{
+    static AsyncWorker worker;
+    return worker;
+}
+
+size_t AsyncWorker::GetPending() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _jobs.size();
+}
+
+void AsyncWorker::_Loop()
+{
+    while (true) {
+        Job job;
+        bool run = true;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+            if (_jobs.empty()) {
+                break;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            run = !_stop;
+        }
+
+        /* 停止后剩余任务不再推理，逐个以空结果完成，保证等待者都能被唤醒 */
+        job(run);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+
+/* 引擎的异步执行线程，按提交顺序依次执行任务，阻塞在rknn_run上的是该线程而非提交者 */
+class AsyncWorker
+{
+public:
+    using Job = std::function<void(bool run)>;  // run为false表示已停止，任务应以空结果完成
+
+    AsyncWorker();
+    ~AsyncWorker();
+
+    void Submit(Job job);
+    void Stop();
+    size_t GetPending() const;
+
+    /* 公共的完成线程，未指定执行器的协程在此恢复 */
+    static AsyncWorker& Completion();
+
+private:
+    std::thread _thread;
+    std::deque<Job> _jobs;
+    mutable std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _stop {false};
+
+    void _Loop();
+};
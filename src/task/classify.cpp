@@ -1,35 +1,76 @@
 #include "classify.hpp"
+#include "ops.hpp"
 
 #include <algorithm>
 #include <chrono>
-#include <arm_fp16.h>
 
 
-Classify::Classify(const std::string &modelPath, int topk) : Engine(modelPath), _topk(topk)
+Classify::Classify(const std::string &modelPath, int topk, MemoryMode mode, MemoryGroup* group) : Engine(modelPath, mode, group), _head(ClassifyHead::Params{topk})
 {
 
 }
 
-Classify::ResultPtr Classify::Predict(void* data, size_t len)
+Classify::~Classify()
 {
-    /* 前处理 */
-    auto t1 = std::chrono::high_resolution_clock::now();
-    AssignInput(data, len);
-    auto t2 = std::chrono::high_resolution_clock::now();
-    _timeCost.preprocess = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
-
-    /* 执行推理 */
-    auto t3 = std::chrono::high_resolution_clock::now();
-    Inference();
-    auto t4 = std::chrono::high_resolution_clock::now();
-    _timeCost.inference = std::chrono::duration_cast<std::chrono::microseconds>(t4 - t3).count();
-
-    /* 后处理 */
-    auto t5 = std::chrono::high_resolution_clock::now();
-    auto result = Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum);
-    auto t6 = std::chrono::high_resolution_clock::now();
-    _timeCost.postprocess = std::chrono::duration_cast<std::chrono::microseconds>(t6 - t5).count();
+    _StopAsync();
+}
+
+Classify::ResultPtr Classify::Predict(const void* data, size_t len)
+{
+    return Run(data, len, [&]() {
+        return Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum);
+    });
+}
+
+void Classify::Predict(const void* data, size_t len, ClassBuffer& result)
+{
+    Run(data, len, [&]() {
+        Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum, result);
+    });
+}
+
+void Classify::Predict(const uint8_t* frame, size_t stride, std::span<const Rect> rois, ClassBuffer* results, bool swapRB)
+{
+    /* 各阶段耗时为所有批次之和 */
+    _timeCost = {0, 0, 0};
+    if (_inputMem == nullptr || _outputMem == nullptr) {
+        return;
+    }
+
+    Size size = GetInputSize();
+    size_t batch = GetBatchSize();
+    for (size_t i = 0; i < rois.size(); i += batch) {
+        size_t n = std::min(batch, rois.size() - i);
+
+        /* 前处理，裁剪缩放结果直接写入输入张量的各批槽 */
+        auto t1 = std::chrono::high_resolution_clock::now();
+        Utils::CropResize(frame, stride, rois.data() + i, n, static_cast<int8_t*>(_inputMem[0]->virt_addr), size, swapRB);
+        SyncInput();
+        auto t2 = std::chrono::high_resolution_clock::now();
+        _timeCost.preprocess += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
 
+        /* 执行推理 */
+        auto t3 = std::chrono::high_resolution_clock::now();
+        Inference();
+        auto t4 = std::chrono::high_resolution_clock::now();
+        _timeCost.inference += std::chrono::duration_cast<std::chrono::microseconds>(t4 - t3).count();
+
+        /* 后处理 */
+        auto t5 = std::chrono::high_resolution_clock::now();
+        for (size_t k = 0; k < n; k++) {
+            Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum, results[i + k], k);
+        }
+        auto t6 = std::chrono::high_resolution_clock::now();
+        _timeCost.postprocess += std::chrono::duration_cast<std::chrono::microseconds>(t6 - t5).count();
+    }
+}
+
+AsyncResult<Classify::ResultPtr> Classify::PredictAsync(const void* data, size_t len)
+{
+    AsyncResult<ResultPtr> result;
+    _Submit([this, data, len, state = result.GetState()](bool run) {
+        state->Set(run ? Predict(data, len) : nullptr);
+    });
     return result;
 }
 
@@ -40,30 +81,66 @@ Classify::ResultPtr Classify::Postprocess(
     size_t num
 )
 {
-    /* (1, classNum) */
-    uint32_t nc = attr[0].dims[1];
-    auto type = attr[0].type;
-    std::vector<Class> classes;
+    ClassBuffer buffer;
+    _head.Decode(*this, {output, attr, nativeAttr, num}, buffer);
 
-    /* 对结果排序 */
+    auto result = std::make_unique<Result>();
+    for (size_t i = 0; i < buffer.Size(); i++) {
+        result->push_back(buffer[i]);
+    }
+    return result;
+}
+
+void Classify::Postprocess(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    size_t num,
+    ClassBuffer& result,
+    size_t slot
+)
+{
+    _head.Decode(*this, {output, attr, nativeAttr, num}, result, slot);
+}
+
+
+ClassifyHead::Result ClassifyHead::Decode(Engine& engine)
+{
+    ClassBuffer result;
+    Decode(engine, engine.GetOutputs(), result);
+    return result;
+}
+
+void ClassifyHead::Decode(Engine& engine, const Engine::Outputs& outputs, ClassBuffer& result, size_t slot)
+{
+    /* (batch, classNum)，slot为批内下标 */
+    const rknn_tensor_attr& attr = outputs.attr[0];
+    uint32_t nc = attr.dims[1];
+    uint32_t base = slot * nc;
+    const void* tensor = outputs.mem[0]->virt_addr;
+    engine.SyncOutput(outputs.mem[0]);
+    _scratch.clear();
     for (uint32_t i = 0; i < nc; i++) {
-        if (type == RKNN_TENSOR_FLOAT32) {
-            classes.emplace_back(i, Output<float>(0, i));
-        } else if (type == RKNN_TENSOR_INT8) {
-            classes.emplace_back(i, Rknn::Quantization::Dequantize(Output<int8_t>(0, i), attr[0].scale, attr[0].zp));
-        } else if (type == RKNN_TENSOR_FLOAT16) {
-            classes.emplace_back(i, static_cast<float>(Output<float16_t>(0, i)));
+        if (attr.type == RKNN_TENSOR_FLOAT32) {
+            _scratch.emplace_back(i, static_cast<const float*>(tensor)[base + i]);
+        } else if (attr.type == RKNN_TENSOR_INT8) {
+            _scratch.emplace_back(i, Rknn::Quantization::Dequantize(static_cast<const int8_t*>(tensor)[base + i], attr.scale, attr.zp));
+        } else if (attr.type == RKNN_TENSOR_FLOAT16) {
+            _scratch.emplace_back(i, static_cast<float>(static_cast<const Half*>(tensor)[base + i]));
         }
     }
-    std::sort(classes.begin(),
-              classes.end(),
-              [](const Class& a, const Class& b) {
-                    return a.score > b.score;
-              });
 
-    /* 取出topk结果 */
-    _topk = _topk > static_cast<int>(nc) || _topk < 0 ? nc : _topk;
-    classes.resize(_topk);
+    /* 只需前topk个有序，部分排序即可 */
+    size_t topk = _params.topk > static_cast<int>(_scratch.size()) || _params.topk < 0 ? _scratch.size() : _params.topk;
+    std::partial_sort(_scratch.begin(),
+                      _scratch.begin() + topk,
+                      _scratch.end(),
+                      [](const Class& a, const Class& b) {
+                            return a.score > b.score;
+                      });
 
-    return std::make_unique<Result>(classes);
+    result.Clear();
+    for (size_t i = 0; i < topk; i++) {
+        result.Push(_scratch[i].index, _scratch[i].score);
+    }
 }
@@ -2,8 +2,10 @@
 
 #include <vector>
 #include <memory>
+#include <span>
 
 #include "engine.hpp"
+#include "async_result.hpp"
 #include "types.hpp"
 
 
@@ -17,15 +19,80 @@ struct Class
 };
 
 
+/* SoA排布的分类结果，由调用方持有并跨帧复用 */
+class ClassBuffer
+{
+public:
+    void Clear()
+    {
+        _ids.clear();
+        _scores.clear();
+    }
+
+    void Push(uint32_t id, float score)
+    {
+        _ids.push_back(id);
+        _scores.push_back(score);
+    }
+
+    size_t Size() const { return _ids.size(); }
+    bool Empty() const { return _ids.empty(); }
+
+    std::span<const uint32_t> Ids() const { return _ids; }
+    std::span<const float> Scores() const { return _scores; }
+
+    Class operator[](size_t i) const
+    {
+        return {_ids[i], _scores[i]};
+    }
+
+private:
+    std::vector<uint32_t> _ids;
+    std::vector<float> _scores;
+};
+
+
+/* 分类解码头，可挂接到任意引擎，也是Classify的后处理实现 */
+class ClassifyHead
+{
+public:
+    struct Params
+    {
+        int topk {5};  // 保留的结果数，小于0或超过类别数时保留全部
+    };
+    using Result = ClassBuffer;
+
+    ClassifyHead() = default;
+    explicit ClassifyHead(const Params& params) : _params(params) {}
+
+    Result Decode(Engine& engine);
+    /* (batch, classNum)输出中解码第slot个样本 */
+    void Decode(Engine& engine, const Engine::Outputs& outputs, ClassBuffer& result, size_t slot = 0);
+
+    const Params& GetParams() const { return _params; }
+
+private:
+    Params _params;
+    std::vector<Class> _scratch;  // 复用的排序缓冲
+};
+
+
 class Classify : public Engine
 {
 public:
     using Result = std::vector<Class>;
     using ResultPtr = std::unique_ptr<Result>;
 
-    explicit Classify(const std::string &modelPath, int topk = 5);
+    explicit Classify(const std::string &modelPath, int topk = 5, MemoryMode mode = MemoryMode::Default, MemoryGroup* group = nullptr);
+
+    ~Classify();
 
-    ResultPtr Predict(void* data, size_t len);
+    ResultPtr Predict(const void* data, size_t len);
+    void Predict(const void* data, size_t len, ClassBuffer& result);
+    /* 裁剪frame中的各区域直接缩放到输入张量，按模型批大小分批推理，results与rois一一对应 */
+    void Predict(const uint8_t* frame, size_t stride, std::span<const Rect> rois, ClassBuffer* results, bool swapRB = true);
+    /* 提交到引擎的执行线程后立即返回，完成前data须保持有效；引擎析构时未执行的请求以空指针完成 */
+    AsyncResult<ResultPtr> PredictAsync(const void* data, size_t len);
 
     ResultPtr Postprocess(
         const rknn_tensor_mem* const* output,
@@ -33,7 +100,15 @@ public:
         const rknn_tensor_attr* nativeAttr,
         size_t num
     );
+    void Postprocess(
+        const rknn_tensor_mem* const* output,
+        const rknn_tensor_attr* attr,
+        const rknn_tensor_attr* nativeAttr,
+        size_t num,
+        ClassBuffer& result,
+        size_t slot = 0
+    );
 
 private:
-    int _topk;
+    ClassifyHead _head;
 };
@@ -1,40 +1,61 @@
 #include <filesystem>
+#include <fstream>
 #include <chrono>
-
-#include "arm_fp16.h"
+#include <algorithm>
 
 #ifdef WITH_NEON
     #include "arm_neon.h"
 #endif
 
 #include "engine.hpp"
+#include "memory_group.hpp"
 
 
-Engine::Engine(const std::string &modelPath)
+Engine::Engine(const std::string &modelPath, MemoryMode mode, MemoryGroup* group) :
+_memoryMode(mode), _group(group)
 {
     Init(modelPath);
 }
 
 Engine::~Engine()
 {
+    _StopAsync();
     Deinit();
 }
 
 void Engine::Init(const std::string &path)
 {
+    /* 重复初始化时先释放上一个模型的上下文及张量内存 */
+    if (_ctx != 0 || _inputMem || _outputMem) {
+        Deinit();
+    }
+
     if (!std::filesystem::exists(path)) {
         std::printf("model %s not exist\r\n", path.c_str());
         return;
     }
 
+    /* 录制文件走回放 */
+    if (std::filesystem::path(path).extension() == ".rec") {
+        _InitReplay(path);
+        return;
+    }
+
     int ret = RKNN_SUCC;
 
-    /* 初始化上下文 */
+    /* 初始化上下文，自行管理内存方式时关闭运行时的整块缓存刷新 */
+    uint32_t flag = RKNN_FLAG_EXECUTE_FALLBACK_PRIOR_DEVICE_GPU;
+    if (_memoryMode != MemoryMode::Default) {
+        flag |= RKNN_FLAG_DISABLE_FLUSH_INPUT_MEM_CACHE | RKNN_FLAG_DISABLE_FLUSH_OUTPUT_MEM_CACHE;
+    }
+    if (_group) {
+        flag |= RKNN_FLAG_MEM_ALLOC_OUTSIDE;
+    }
     ret = rknn_init(
         &_ctx,
         static_cast<void *>(const_cast<char *>(path.c_str())),
         0,
-        RKNN_FLAG_EXECUTE_FALLBACK_PRIOR_DEVICE_GPU,
+        flag,
         nullptr
     );
     if (ret != RKNN_SUCC) {
@@ -48,6 +69,17 @@ void Engine::Init(const std::string &path)
         std::printf("RKNN set core mask failed\r\n");
     }
 
+    /* 内部工作内存交由共享组在首次推理前分配 */
+    if (_group) {
+        rknn_mem_size memSize;
+        std::memset(&memSize, 0, sizeof(memSize));
+        ret = rknn_query(_ctx, RKNN_QUERY_MEM_SIZE, &memSize, sizeof(memSize));
+        if (ret != RKNN_SUCC) {
+            std::printf("query mem size failed\r\n");
+        }
+        _group->Attach(_ctx, memSize);
+    }
+
     /* 获取输入输出张量数量 */
     rknn_input_output_num ioNum;
     ret = rknn_query(_ctx, RKNN_QUERY_IN_OUT_NUM, &ioNum, sizeof(rknn_input_output_num));
@@ -60,7 +92,7 @@ void Engine::Init(const std::string &path)
 
     /* 分配输入张量内存 */
     _inputNativeAttr = new rknn_tensor_attr[_inputNum];
-    _inputMem = new rknn_tensor_mem*[_inputNum];
+    _inputMem = new rknn_tensor_mem*[_inputNum]();
     for (uint32_t i = 0; i < _inputNum; i++) {
         _inputNativeAttr[i].index = i;
         ret = rknn_query(_ctx, RKNN_QUERY_NATIVE_INPUT_ATTR, &_inputNativeAttr[i], sizeof(rknn_tensor_attr));
@@ -68,9 +100,10 @@ void Engine::Init(const std::string &path)
             std::printf("query input %d native attribute failed\r\n", i);
         }
 
-        _inputMem[i] = rknn_create_mem(_ctx, _inputNativeAttr[i].size_with_stride);
-        if (_inputMem == nullptr) {
+        _inputMem[i] = _CreateMem(_inputNativeAttr[i].size_with_stride);
+        if (_inputMem[i] == nullptr) {
             std::printf("allocate input %d memory failed\r\n", i);
+            continue;
         }
 
         ret = rknn_set_io_mem(_ctx, _inputMem[i], &_inputNativeAttr[i]);
@@ -82,7 +115,7 @@ void Engine::Init(const std::string &path)
 
     /* 分配输出张量内存 */
     _outputNativeAttr = new rknn_tensor_attr[_outputNum];
-    _outputMem = new rknn_tensor_mem*[_outputNum];
+    _outputMem = new rknn_tensor_mem*[_outputNum]();
     for (uint32_t i = 0; i < _outputNum; i++) {
         _outputNativeAttr[i].index = i;
         ret = rknn_query(_ctx, RKNN_QUERY_NATIVE_OUTPUT_ATTR, &_outputNativeAttr[i], sizeof(rknn_tensor_attr));
@@ -90,9 +123,10 @@ void Engine::Init(const std::string &path)
             std::printf("query output %d native attribute failed\r\n", i);
         }
 
-        _outputMem[i] = rknn_create_mem(_ctx, _outputNativeAttr[i].size_with_stride);
-        if (_outputMem == nullptr) {
+        _outputMem[i] = _CreateMem(_outputNativeAttr[i].size_with_stride);
+        if (_outputMem[i] == nullptr) {
             std::printf("allocate output %d memory failed\r\n", i);
+            continue;
         }
 
         ret = rknn_set_io_mem(_ctx, _outputMem[i], &_outputNativeAttr[i]);
@@ -122,13 +156,24 @@ void Engine::Init(const std::string &path)
         }
     }
     _DumpTensorInfo("Output tensor attribute", _outputAttr, _outputNum);
+
+    /* 枚举动态输入尺寸 */
+    _InitShapes();
 }
 
 void Engine::Deinit()
 {
     if (_inputMem) {
         for (uint32_t i = 0; i < _inputNum; i++) {
-            rknn_destroy_mem(_ctx, _inputMem[i]);
+            if (_inputMem[i] == nullptr) {
+                continue;
+            }
+            if (_replay) {
+                delete[] static_cast<uint8_t *>(_inputMem[i]->virt_addr);
+                delete _inputMem[i];
+            } else {
+                rknn_destroy_mem(_ctx, _inputMem[i]);
+            }
             _inputMem[i] = nullptr;
         }
         delete[] _inputMem;
@@ -136,7 +181,15 @@ void Engine::Deinit()
     }
     if (_outputMem) {
         for (uint32_t i = 0; i < _outputNum; i++) {
-            rknn_destroy_mem(_ctx, _outputMem[i]);
+            if (_outputMem[i] == nullptr) {
+                continue;
+            }
+            if (_replay) {
+                delete[] static_cast<uint8_t *>(_outputMem[i]->virt_addr);
+                delete _outputMem[i];
+            } else {
+                rknn_destroy_mem(_ctx, _outputMem[i]);
+            }
             _outputMem[i] = nullptr;
         }
         delete[] _outputMem;
@@ -161,7 +214,27 @@ void Engine::Deinit()
         _outputNativeAttr = nullptr;
     }
 
+    _inputShapes.clear();
+    _shapeAttr.clear();
+    _shapeIndex = 0;
+    _outputSynced.clear();
+    _inputNum = 0;
+    _outputNum = 0;
+
+    if (_replay) {
+        _replay = false;
+        return;
+    }
+
+    /* 初始化失败时上下文为空，无需销毁 */
+    if (_ctx == 0) {
+        return;
+    }
+    if (_group) {
+        _group->Detach(_ctx);
+    }
     rknn_destroy(_ctx);
+    _ctx = 0;
 }
 
 void Engine::AssignInput(const void *data, size_t len)
@@ -182,10 +255,30 @@ void Engine::AssignInput(const void *data, size_t len)
         Input<int8_t>(i) = (sp[i] - 128);
     }
 #endif
+
+    SyncInput();
 }
 
 int Engine::Inference()
 {
+    /* 回放模式下输出张量保持录制内容 */
+    if (_replay) {
+        _timeCost.inference = 0;
+        return RKNN_SUCC;
+    }
+
+    _outputSynced.assign(_outputNum, false);
+
+    /* 共享内部内存的模型互斥执行 */
+    std::unique_lock<std::mutex> lock;
+    if (_group) {
+        lock = _group->Lock();
+        if (!lock.owns_lock()) {
+            std::printf("bind shared internal memory failed\r\n");
+            return RKNN_ERR_MALLOC_FAIL;
+        }
+    }
+
     auto t1 = std::chrono::high_resolution_clock::now();
     int ret = rknn_run(_ctx, nullptr);
     auto t2 = std::chrono::high_resolution_clock::now();
@@ -196,8 +289,70 @@ int Engine::Inference()
     return ret;
 }
 
+void Engine::SyncInput()
+{
+    /* 可缓存内存需将CPU写入刷到设备 */
+    if (_memoryMode == MemoryMode::Cached && !_replay) {
+        rknn_mem_sync(_ctx, _inputMem[0], RKNN_MEMORY_SYNC_TO_DEVICE);
+    }
+}
+
+void Engine::SyncOutput(const rknn_tensor_mem* mem)
+{
+    /* 仅Cached模式需要在CPU读取前使缓存失效，每次推理每个输出张量只同步一次 */
+    if (_memoryMode != MemoryMode::Cached || _replay) {
+        return;
+    }
+    for (uint32_t i = 0; i < _outputNum && i < _outputSynced.size(); i++) {
+        if (_outputMem[i] == mem) {
+            if (!_outputSynced[i]) {
+                rknn_mem_sync(_ctx, _outputMem[i], RKNN_MEMORY_SYNC_FROM_DEVICE);
+                _outputSynced[i] = true;
+            }
+            return;
+        }
+    }
+}
+
+void Engine::Record(const std::string &path) const
+{
+    /* 文件格式：magic、版本、输入输出数量，每个输入的属性，每个输出的属性及数据 */
+    std::fstream ofs(path, std::ios::out | std::ios::binary);
+    if (!ofs.good()) {
+        std::printf("open record file %s failed\r\n", path.c_str());
+        return;
+    }
+
+    uint32_t header[4] = {_recordMagic, _recordVersion, _inputNum, _outputNum};
+    ofs.write(reinterpret_cast<const char *>(header), sizeof(header));
+    for (uint32_t i = 0; i < _inputNum; i++) {
+        ofs.write(reinterpret_cast<const char *>(&_inputAttr[i]), sizeof(rknn_tensor_attr));
+        ofs.write(reinterpret_cast<const char *>(&_inputNativeAttr[i]), sizeof(rknn_tensor_attr));
+    }
+    for (uint32_t i = 0; i < _outputNum; i++) {
+        uint32_t size = _outputMem[i]->size;
+        ofs.write(reinterpret_cast<const char *>(&_outputAttr[i]), sizeof(rknn_tensor_attr));
+        ofs.write(reinterpret_cast<const char *>(&_outputNativeAttr[i]), sizeof(rknn_tensor_attr));
+        ofs.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        ofs.write(static_cast<const char *>(_outputMem[i]->virt_addr), size);
+    }
+
+    ofs.close();
+    std::printf("recorded %d output tensors to %s\r\n", _outputNum, path.c_str());
+}
+
+Engine::Outputs Engine::GetOutputs() const
+{
+    return {_outputMem, _outputAttr, _outputNativeAttr, _outputNum};
+}
+
 Size Engine::GetInputSize() const
 {
+    /* 初始化失败时没有输入张量 */
+    if (_inputAttr == nullptr || _inputNum == 0) {
+        return {};
+    }
+
     if (_inputAttr[0].fmt == RKNN_TENSOR_NCHW) {
         return {
             static_cast<int>(_inputAttr[0].dims[3]),
@@ -213,11 +368,283 @@ Size Engine::GetInputSize() const
     }
 }
 
+uint32_t Engine::GetBatchSize() const
+{
+    /* 批维度在NCHW及NHWC中均为第0维 */
+    if (_inputAttr == nullptr || _inputAttr[0].n_dims == 0) {
+        return 1;
+    }
+    return std::max<uint32_t>(_inputAttr[0].dims[0], 1);
+}
+
+const std::vector<Size>& Engine::GetInputShapes() const
+{
+    return _inputShapes;
+}
+
+bool Engine::SetInputShape(size_t index)
+{
+    if (index >= _shapeAttr.size()) {
+        return false;
+    }
+    if (index == _shapeIndex) {
+        return true;
+    }
+
+    /* 切换输入尺寸 */
+    ShapeAttr &attr = _shapeAttr[index];
+    int ret = rknn_set_input_shapes(_ctx, _inputNum, attr.input.data());
+    if (ret != RKNN_SUCC) {
+        std::printf("set input shape %dx%d failed\r\n", _inputShapes[index].width, _inputShapes[index].height);
+        return false;
+    }
+
+    /* 使用缓存的张量属性，无需重新查询 */
+    std::copy(attr.input.begin(), attr.input.end(), _inputAttr);
+    std::copy(attr.inputNative.begin(), attr.inputNative.end(), _inputNativeAttr);
+    std::copy(attr.output.begin(), attr.output.end(), _outputAttr);
+    std::copy(attr.outputNative.begin(), attr.outputNative.end(), _outputNativeAttr);
+
+    /* 按新的原始属性重新绑定输入输出内存 */
+    for (uint32_t i = 0; i < _inputNum; i++) {
+        rknn_set_io_mem(_ctx, _inputMem[i], &_inputNativeAttr[i]);
+    }
+    for (uint32_t i = 0; i < _outputNum; i++) {
+        rknn_set_io_mem(_ctx, _outputMem[i], &_outputNativeAttr[i]);
+    }
+
+    _shapeIndex = index;
+    return true;
+}
+
+Size Engine::SelectInputSize(const Size& frame)
+{
+    if (_inputShapes.empty() || frame.width <= 0 || frame.height <= 0) {
+        return GetInputSize();
+    }
+
+    /* 各尺寸下按比例缩放后的缩放系数，系数最大者分辨率最高 */
+    auto ratio = [&](const Size& s) {
+        return std::min(s.width / 1.f / frame.width, s.height / 1.f / frame.height);
+    };
+    float best = 0.f;
+    for (auto &shape : _inputShapes) {
+        best = std::max(best, ratio(shape));
+    }
+
+    /* 在不降低有效分辨率的前提下选择面积最小的尺寸，如16:9画面选择640x384而非640x640 */
+    size_t index = _shapeIndex;
+    int area = -1;
+    for (size_t i = 0; i < _inputShapes.size(); i++) {
+        if (ratio(_inputShapes[i]) < best * 0.999f) {
+            continue;
+        }
+        if (area < 0 || _inputShapes[i].size() < area) {
+            index = i;
+            area = _inputShapes[i].size();
+        }
+    }
+
+    SetInputShape(index);
+    return GetInputSize();
+}
+
 const Engine::TimeCost& Engine::GetTimeCost() const
 {
     return _timeCost;
 }
 
+void Engine::_Submit(AsyncWorker::Job job)
+{
+    std::call_once(_asyncOnce, [this]() { _async = std::make_unique<AsyncWorker>(); });
+    _async->Submit(std::move(job));
+}
+
+void Engine::_StopAsync()
+{
+    if (_async) {
+        _async->Stop();
+    }
+}
+
+rknn_tensor_mem* Engine::_CreateMem(uint32_t size)
+{
+    switch (_memoryMode)
+    {
+        case MemoryMode::Uncached:
+            return rknn_create_mem2(_ctx, size, RKNN_FLAG_MEMORY_NON_CACHEABLE);
+
+        case MemoryMode::Cached:
+            return rknn_create_mem2(_ctx, size, RKNN_FLAG_MEMORY_CACHEABLE);
+
+        default:
+            return rknn_create_mem(_ctx, size);
+    }
+}
+
+void Engine::_InitReplay(const std::string &path)
+{
+    std::fstream ifs(path, std::ios::in | std::ios::binary);
+    uint32_t header[4] = {0};
+    ifs.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!ifs.good() || header[0] != _recordMagic || header[1] != _recordVersion) {
+        std::printf("invalid record file %s\r\n", path.c_str());
+        return;
+    }
+
+    /* 张量数及数据长度来自文件，分配前先与文件长度核对，损坏或截断的文件按初始化失败处理 */
+    std::error_code ec;
+    uint64_t remain = std::filesystem::file_size(path, ec);
+    remain = ec || remain < sizeof(header) ? 0 : remain - sizeof(header);
+    uint64_t attrSize = 2 * sizeof(rknn_tensor_attr);
+    uint64_t need = header[2] * attrSize + header[3] * (attrSize + sizeof(uint32_t));
+    if (need > remain) {
+        std::printf("record file %s truncated: %u inputs, %u outputs need %lu bytes, %lu left\r\n",
+                    path.c_str(), header[2], header[3], need, remain);
+        return;
+    }
+    remain -= need;
+
+    _replay = true;
+    _inputNum = header[2];
+    _outputNum = header[3];
+    auto fail = [&](const char* reason) {
+        std::printf("record file %s %s\r\n", path.c_str(), reason);
+        Deinit();
+    };
+
+    /* 输入张量仅分配内存，供前处理写入 */
+    _inputAttr = new rknn_tensor_attr[_inputNum];
+    _inputNativeAttr = new rknn_tensor_attr[_inputNum];
+    _inputMem = new rknn_tensor_mem*[_inputNum]();
+    for (uint32_t i = 0; i < _inputNum; i++) {
+        ifs.read(reinterpret_cast<char *>(&_inputAttr[i]), sizeof(rknn_tensor_attr));
+        ifs.read(reinterpret_cast<char *>(&_inputNativeAttr[i]), sizeof(rknn_tensor_attr));
+        if (!ifs.good() || _inputAttr[i].n_dims > RKNN_MAX_DIMS || _inputNativeAttr[i].n_dims > RKNN_MAX_DIMS) {
+            return fail("has invalid input attribute");
+        }
+        _inputMem[i] = new rknn_tensor_mem();
+        _inputMem[i]->size = _inputNativeAttr[i].size_with_stride;
+        _inputMem[i]->virt_addr = new uint8_t[_inputMem[i]->size];
+    }
+    _DumpTensorInfo("Input tensor native attribute", _inputNativeAttr, _inputNum);
+
+    /* 输出张量载入录制数据 */
+    _outputAttr = new rknn_tensor_attr[_outputNum];
+    _outputNativeAttr = new rknn_tensor_attr[_outputNum];
+    _outputMem = new rknn_tensor_mem*[_outputNum]();
+    for (uint32_t i = 0; i < _outputNum; i++) {
+        uint32_t size = 0;
+        ifs.read(reinterpret_cast<char *>(&_outputAttr[i]), sizeof(rknn_tensor_attr));
+        ifs.read(reinterpret_cast<char *>(&_outputNativeAttr[i]), sizeof(rknn_tensor_attr));
+        ifs.read(reinterpret_cast<char *>(&size), sizeof(size));
+        if (!ifs.good() || _outputAttr[i].n_dims > RKNN_MAX_DIMS || _outputNativeAttr[i].n_dims > RKNN_MAX_DIMS) {
+            return fail("has invalid output attribute");
+        }
+        if (size > remain) {
+            return fail("truncated");
+        }
+        remain -= size;
+        _outputMem[i] = new rknn_tensor_mem();
+        _outputMem[i]->size = size;
+        _outputMem[i]->virt_addr = new uint8_t[size];
+        ifs.read(static_cast<char *>(_outputMem[i]->virt_addr), size);
+        if (!ifs.good()) {
+            return fail("truncated");
+        }
+    }
+    _DumpTensorInfo("Output tensor native attribute", _outputNativeAttr, _outputNum);
+    ifs.close();
+}
+
+void Engine::_InitShapes()
+{
+    rknn_input_range range;
+    std::memset(&range, 0, sizeof(range));
+    range.index = 0;
+    int ret = rknn_query(_ctx, RKNN_QUERY_INPUT_DYNAMIC_RANGE, &range, sizeof(range));
+    if (ret != RKNN_SUCC || range.shape_number <= 1) {
+        return;
+    }
+
+    /* 逐个尺寸切换并查询张量属性 */
+    Size initial = GetInputSize();
+    std::vector<uint32_t> inputSize(_inputNum, 0);
+    std::vector<uint32_t> outputSize(_outputNum, 0);
+    for (uint32_t s = 0; s < range.shape_number; s++) {
+        ShapeAttr attr;
+        attr.input.assign(_inputAttr, _inputAttr + _inputNum);
+        for (uint32_t i = 0; i < _inputNum; i++) {
+            rknn_input_range r;
+            std::memset(&r, 0, sizeof(r));
+            r.index = i;
+            rknn_query(_ctx, RKNN_QUERY_INPUT_DYNAMIC_RANGE, &r, sizeof(r));
+            attr.input[i].n_dims = r.n_dims;
+            attr.input[i].fmt = r.fmt;
+            std::memcpy(attr.input[i].dims, r.dyn_range[s], r.n_dims * sizeof(uint32_t));
+        }
+
+        ret = rknn_set_input_shapes(_ctx, _inputNum, attr.input.data());
+        if (ret != RKNN_SUCC) {
+            std::printf("set input shape %d failed\r\n", s);
+            continue;
+        }
+
+        attr.inputNative.resize(_inputNum);
+        for (uint32_t i = 0; i < _inputNum; i++) {
+            attr.input[i].index = i;
+            attr.inputNative[i].index = i;
+            rknn_query(_ctx, RKNN_QUERY_CURRENT_INPUT_ATTR, &attr.input[i], sizeof(rknn_tensor_attr));
+            rknn_query(_ctx, RKNN_QUERY_CURRENT_NATIVE_INPUT_ATTR, &attr.inputNative[i], sizeof(rknn_tensor_attr));
+            inputSize[i] = std::max(inputSize[i], attr.inputNative[i].size_with_stride);
+        }
+        attr.output.resize(_outputNum);
+        attr.outputNative.resize(_outputNum);
+        for (uint32_t i = 0; i < _outputNum; i++) {
+            attr.output[i].index = i;
+            attr.outputNative[i].index = i;
+            rknn_query(_ctx, RKNN_QUERY_CURRENT_OUTPUT_ATTR, &attr.output[i], sizeof(rknn_tensor_attr));
+            rknn_query(_ctx, RKNN_QUERY_CURRENT_NATIVE_OUTPUT_ATTR, &attr.outputNative[i], sizeof(rknn_tensor_attr));
+            outputSize[i] = std::max(outputSize[i], attr.outputNative[i].size_with_stride);
+        }
+
+        const rknn_tensor_attr &in = attr.input[0];
+        if (in.fmt == RKNN_TENSOR_NCHW) {
+            _inputShapes.emplace_back(in.dims[3], in.dims[2]);
+        } else {
+            _inputShapes.emplace_back(in.dims[2], in.dims[1]);
+        }
+        _shapeAttr.push_back(std::move(attr));
+    }
+
+    /* 按各尺寸中最大的张量重新分配内存 */
+    for (uint32_t i = 0; i < _inputNum; i++) {
+        if (inputSize[i] > _inputMem[i]->size) {
+            rknn_destroy_mem(_ctx, _inputMem[i]);
+            _inputMem[i] = _CreateMem(inputSize[i]);
+        }
+    }
+    for (uint32_t i = 0; i < _outputNum; i++) {
+        if (outputSize[i] > _outputMem[i]->size) {
+            rknn_destroy_mem(_ctx, _outputMem[i]);
+            _outputMem[i] = _CreateMem(outputSize[i]);
+        }
+    }
+
+    /* 恢复为模型初始尺寸 */
+    std::printf("Input shapes:");
+    size_t index = 0;
+    for (size_t i = 0; i < _inputShapes.size(); i++) {
+        std::printf(" %dx%d", _inputShapes[i].width, _inputShapes[i].height);
+        if (_inputShapes[i].width == initial.width && _inputShapes[i].height == initial.height) {
+            index = i;
+        }
+    }
+    std::printf("\r\n");
+    _shapeIndex = _shapeAttr.size();
+    SetInputShape(index);
+}
+
 void Engine::_DumpTensorInfo(const char* tag, const rknn_tensor_attr *attr, int num)
 {
     std::printf("%s:\r\n", tag);
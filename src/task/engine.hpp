@@ -5,12 +5,18 @@
 #include <cstring>
 #include <memory>
 #include <vector>
+#include <mutex>
+#include <chrono>
+#include <type_traits>
 
 #include "rknn_api.h"
 
 #include "types.hpp"
+#include "async_worker.hpp"
 
 
+class MemoryGroup;
+
 class Engine
 {
 public:
@@ -21,16 +27,69 @@ public:
         int64_t postprocess {-1};
     };
 
-    explicit Engine(const std::string &modelPath);
+    /* 一次推理的全部输出张量 */
+    struct Outputs
+    {
+        const rknn_tensor_mem* const* mem {nullptr};
+        const rknn_tensor_attr* attr {nullptr};
+        const rknn_tensor_attr* nativeAttr {nullptr};
+        size_t num {0};
+    };
+
+    /* 输入输出张量的内存方式 */
+    enum class MemoryMode
+    {
+        Default,  // 运行时分配，每次推理前后由运行时整块刷新缓存
+        Uncached,  // 不可缓存内存，无需同步但CPU读取较慢
+        Cached,  // 可缓存内存，由CPU在读写张量前按需逐张量同步
+    };
+
+    /* group非空时内部工作内存由该组统一分配，与组内其他模型共享 */
+    explicit Engine(const std::string &modelPath, MemoryMode mode = MemoryMode::Default, MemoryGroup* group = nullptr);
     ~Engine();
 
     void Init(const std::string &path);
     void Deinit();
     void AssignInput(const void *data, size_t len);
     int Inference();
+    void SyncInput();
+    void SyncOutput(const rknn_tensor_mem* mem);
+    void Record(const std::string &path) const;
+    Outputs GetOutputs() const;
     Size GetInputSize() const;
+    uint32_t GetBatchSize() const;
+    const std::vector<Size>& GetInputShapes() const;
+    bool SetInputShape(size_t index);
+    Size SelectInputSize(const Size& frame);
     const TimeCost& GetTimeCost() const;
 
+    /* 通用推理流程：写入输入、推理、解码，统一统计各阶段耗时，decode的返回值即为结果 */
+    template<typename Decode>
+    decltype(auto) Run(const void* data, size_t len, Decode&& decode)
+    {
+        /* 前处理 */
+        auto t1 = std::chrono::high_resolution_clock::now();
+        AssignInput(data, len);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        _timeCost.preprocess = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+
+        /* 执行推理 */
+        Inference();
+
+        /* 后处理 */
+        auto t3 = std::chrono::high_resolution_clock::now();
+        if constexpr (std::is_void_v<std::invoke_result_t<Decode>>) {
+            decode();
+            auto t4 = std::chrono::high_resolution_clock::now();
+            _timeCost.postprocess = std::chrono::duration_cast<std::chrono::microseconds>(t4 - t3).count();
+        } else {
+            auto result = decode();
+            auto t4 = std::chrono::high_resolution_clock::now();
+            _timeCost.postprocess = std::chrono::duration_cast<std::chrono::microseconds>(t4 - t3).count();
+            return result;
+        }
+    }
+
 protected:
     rknn_context _ctx = 0;
     rknn_tensor_mem **_inputMem = nullptr;
@@ -42,8 +101,18 @@ protected:
     rknn_tensor_attr *_inputNativeAttr = nullptr;
     rknn_tensor_attr *_outputNativeAttr = nullptr;
 
+    bool _replay = false;  // 回放录制的输出张量，不使用NPU
+    MemoryMode _memoryMode;
+    MemoryGroup* _group;
+    std::vector<bool> _outputSynced;  // Cached模式下本次推理各输出张量是否已同步
+
     TimeCost _timeCost;
 
+    /* 异步任务在引擎专属的执行线程上依次执行，首次提交时启动 */
+    void _Submit(AsyncWorker::Job job);
+    /* 带异步接口的派生类须在析构开头调用，保证执行线程不再访问派生类成员 */
+    void _StopAsync();
+
     template<typename T>
     inline T& Input(int index)
     {
@@ -57,5 +126,30 @@ protected:
     }
 
 private:
+    template<typename H>
+    friend class Predictor;
+
+    /* 动态输入模型每种输入尺寸对应的张量属性 */
+    struct ShapeAttr
+    {
+        std::vector<rknn_tensor_attr> input;
+        std::vector<rknn_tensor_attr> inputNative;
+        std::vector<rknn_tensor_attr> output;
+        std::vector<rknn_tensor_attr> outputNative;
+    };
+
+    std::unique_ptr<AsyncWorker> _async;
+    std::once_flag _asyncOnce;
+
+    std::vector<Size> _inputShapes;  // 支持的输入尺寸，静态模型为空
+    std::vector<ShapeAttr> _shapeAttr;
+    size_t _shapeIndex = 0;  // 当前输入尺寸下标
+
+    static constexpr uint32_t _recordMagic = 0x43524b52;  // "RKRC"
+    static constexpr uint32_t _recordVersion = 1;
+
+    rknn_tensor_mem* _CreateMem(uint32_t size);
+    void _InitReplay(const std::string &path);
+    void _InitShapes();
     void _DumpTensorInfo(const char* tag, const rknn_tensor_attr *attr, int num);
 };
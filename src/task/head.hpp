@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+
+#include "engine.hpp"
+#include "async_result.hpp"
+#include "histogram.hpp"
+
+
+/* 解码头：只负责把一次推理的输出张量解码为结果，参数为编译期确定类型的结构体 */
+template<typename H>
+concept Head = requires(H head, Engine& engine) {
+    typename H::Params;
+    typename H::Result;
+    requires std::default_initializable<typename H::Result>;
+    { head.Decode(engine) } -> std::same_as<typename H::Result>;
+};
+
+
+/* 把解码头挂接到任意引擎上，复用统一的推理流程、异步执行及分阶段耗时统计 */
+/* 引擎中以无约束形式声明为友元，这里用static_assert检查约束 */
+template<typename H>
+class Predictor
+{
+    static_assert(Head<H>, "H must satisfy Head");
+
+public:
+    using Params = typename H::Params;
+    using Result = typename H::Result;
+
+    struct Stats
+    {
+        Histogram preprocess;
+        Histogram inference;
+        Histogram postprocess;
+    };
+
+    Predictor(Engine& engine, const Params& params) :
+    _engine(engine), _head(params) {}
+
+    explicit Predictor(Engine& engine) :
+    _engine(engine) {}
+
+    /* 等待本对象提交的异步请求全部完成，之后引擎的执行线程不再访问解码头 */
+    ~Predictor()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cond.wait(lock, [this]() { return _pending == 0; });
+    }
+
+    /* 在调用线程上执行，不可与本对象未完成的异步请求同时使用，混用时经由PredictorPool */
+    Result Predict(const void* data, size_t len)
+    {
+        Result result = _engine.Run(data, len, [this]() { return _head.Decode(_engine); });
+        _Record();
+        return result;
+    }
+
+    /* 在引擎的执行线程上推理及解码，完成前data须保持有效 */
+    AsyncResult<Result> PredictAsync(const void* data, size_t len)
+    {
+        AsyncResult<Result> result;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending++;
+        }
+        _engine._Submit([this, data, len, state = result.GetState()](bool run) {
+            Result value = run ? Predict(data, len) : Result();
+
+            /* 先持锁计数并通知，再交付结果；交付后等待方可能析构本对象，本任务不再访问成员 */
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _pending--;
+                _cond.notify_all();
+            }
+            state->Set(std::move(value));
+        });
+        return result;
+    }
+
+    size_t GetPending() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _pending;
+    }
+
+    Stats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    Engine& GetEngine() { return _engine; }
+    H& GetHead() { return _head; }
+
+private:
+    Engine& _engine;
+    H _head;
+    mutable std::mutex _mutex;
+    std::condition_variable _cond;
+    size_t _pending {0};
+    Stats _stats;
+
+    void _Record()
+    {
+        const auto &cost = _engine.GetTimeCost();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.preprocess.Add(cost.preprocess);
+        _stats.inference.Add(cost.inference);
+        _stats.postprocess.Add(cost.postprocess);
+    }
+};
+
+
+/* 同一模型的多个上下文，每个上下文挂接一个解码头 */
+/* 同步及异步请求都提交到排队最少的上下文的执行线程，同一上下文上的请求串行执行，多个请求在不同上下文上流水执行 */
+template<Head H>
+class PredictorPool
+{
+public:
+    using Params = typename H::Params;
+    using Result = typename H::Result;
+    using Stats = typename Predictor<H>::Stats;
+
+    PredictorPool(const std::string& modelPath, int contexts, const Params& params)
+    {
+        for (int i = 0; i < std::max(contexts, 1); i++) {
+            _engines.push_back(std::make_unique<Engine>(modelPath));
+            _predictors.push_back(std::make_unique<Predictor<H>>(*_engines.back(), params));
+        }
+    }
+
+    ~PredictorPool()
+    {
+        /* 解码头先于引擎析构 */
+        _predictors.clear();
+        _engines.clear();
+    }
+
+    /* 不在调用线程上直接推理，避免与已排队的异步请求同时使用同一上下文的输入输出内存 */
+    Result Predict(const void* data, size_t len)
+    {
+        return PredictAsync(data, len).Get();
+    }
+
+    AsyncResult<Result> PredictAsync(const void* data, size_t len)
+    {
+        /* 从轮转位置起取排队最少的上下文，排队数相同时各上下文轮流分担 */
+        size_t num = _predictors.size();
+        size_t start = _next.fetch_add(1);
+        size_t index = start % num;
+        size_t least = _predictors[index]->GetPending();
+        for (size_t k = 1; k < num && least > 0; k++) {
+            size_t i = (start + k) % num;
+            size_t pending = _predictors[i]->GetPending();
+            if (pending < least) {
+                index = i;
+                least = pending;
+            }
+        }
+        return _predictors[index]->PredictAsync(data, len);
+    }
+
+    size_t GetSize() const { return _predictors.size(); }
+    Predictor<H>& operator[](size_t index) { return *_predictors[index]; }
+
+    Stats GetStats() const
+    {
+        Stats stats;
+        for (auto &&predictor : _predictors) {
+            Stats s = predictor->GetStats();
+            stats.preprocess.Merge(s.preprocess);
+            stats.inference.Merge(s.inference);
+            stats.postprocess.Merge(s.postprocess);
+        }
+        return stats;
+    }
+
+    void Dump(const char* tag) const
+    {
+        Stats stats = GetStats();
+        std::printf("%s: %ld contexts\r\n", tag, _predictors.size());
+        stats.preprocess.Dump("  preprocess");
+        stats.inference.Dump("  inference");
+        stats.postprocess.Dump("  postprocess");
+    }
+
+private:
+    std::vector<std::unique_ptr<Engine>> _engines;
+    std::vector<std::unique_ptr<Predictor<H>>> _predictors;
+    std::atomic<size_t> _next {0};
+};
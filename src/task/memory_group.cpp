@@ -0,0 +1,193 @@
+#include "memory_group.hpp"
+
+#include <cstdio>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/dma-heap.h>
+
+
+MemoryGroup::MemoryGroup(const std::string& heap) :
+_heap(heap)
+{
+
+}
+
+MemoryGroup::~MemoryGroup()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_members.empty()) {
+        std::printf("memory group destroyed with %ld attached contexts\r\n", _members.size());
+    }
+    _Unbind();
+    _Free();
+}
+
+void MemoryGroup::Attach(rknn_context ctx, const rknn_mem_size& size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _members.push_back({ctx, size.total_internal_size, size.total_weight_size, nullptr});
+}
+
+void MemoryGroup::Detach(rknn_context ctx)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = std::find_if(_members.begin(), _members.end(), [ctx](const Member& m) { return m.ctx == ctx; });
+    if (it == _members.end()) {
+        return;
+    }
+    if (it->mem) {
+        rknn_destroy_mem(it->ctx, it->mem);
+    }
+    _members.erase(it);
+
+    /* 最后一个成员离开时释放共享内存 */
+    if (_members.empty()) {
+        _Free();
+    }
+}
+
+std::unique_lock<std::mutex> MemoryGroup::Lock()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_Bind()) {
+        lock.unlock();
+    }
+    return lock;
+}
+
+uint64_t MemoryGroup::GetSharedSize() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size;
+}
+
+uint64_t MemoryGroup::GetSeparateSize() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t total = 0;
+    for (auto &&m : _members) {
+        total += m.internal;
+    }
+    return total;
+}
+
+void MemoryGroup::Dump() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t separate = 0;
+    uint64_t shared = _size;  // 尚未绑定时按最大需求估算
+    for (size_t i = 0; i < _members.size(); i++) {
+        std::printf("  model %ld: internal %u bytes, weight %u bytes%s\r\n",
+                    i,
+                    _members[i].internal,
+                    _members[i].weight,
+                    _members[i].mem ? "" : " (unbound)");
+        separate += _members[i].internal;
+        shared = std::max<uint64_t>(shared, _members[i].internal);
+    }
+    std::printf("memory group: %ld models, separate internal: %lu bytes, shared internal: %lu bytes, saved: %ld bytes\r\n",
+                _members.size(),
+                separate,
+                shared,
+                static_cast<int64_t>(separate) - static_cast<int64_t>(shared));
+}
+
+bool MemoryGroup::_Bind()
+{
+    /* 新成员的需求超过现有容量时整体重新分配，调用方持锁，此时组内没有推理在执行 */
+    uint64_t required = 0;
+    bool bound = true;
+    for (auto &&m : _members) {
+        required = std::max<uint64_t>(required, m.internal);
+        bound = bound && m.mem != nullptr;
+    }
+    if (bound && required <= _size) {
+        return true;
+    }
+    if (required > _size) {
+        _Unbind();
+        _Free();
+        if (!_Allocate(required)) {
+            return false;
+        }
+    }
+
+    /* 每个上下文按各自需求导入同一块dma-buf */
+    for (auto &&m : _members) {
+        if (m.mem) {
+            continue;
+        }
+        m.mem = rknn_create_mem_from_fd(m.ctx, _fd, _addr, m.internal, 0);
+        if (m.mem == nullptr) {
+            std::printf("import shared internal memory failed\r\n");
+            return false;
+        }
+        int ret = rknn_set_internal_mem(m.ctx, m.mem);
+        if (ret != RKNN_SUCC) {
+            std::printf("set internal memory failed, ret: %d\r\n", ret);
+            rknn_destroy_mem(m.ctx, m.mem);
+            m.mem = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+void MemoryGroup::_Unbind()
+{
+    for (auto &&m : _members) {
+        if (m.mem) {
+            rknn_destroy_mem(m.ctx, m.mem);
+            m.mem = nullptr;
+        }
+    }
+}
+
+bool MemoryGroup::_Allocate(uint64_t size)
+{
+    size = (size + 4095) & ~static_cast<uint64_t>(4095);
+
+    int heap = open(_heap.c_str(), O_RDWR | O_CLOEXEC);
+    if (heap < 0) {
+        std::printf("open dma heap %s failed\r\n", _heap.c_str());
+        return false;
+    }
+    dma_heap_allocation_data data {};
+    data.len = size;
+    data.fd_flags = O_RDWR | O_CLOEXEC;
+    int ret = ioctl(heap, DMA_HEAP_IOCTL_ALLOC, &data);
+    close(heap);
+    if (ret < 0) {
+        std::printf("allocate %lu bytes from dma heap %s failed\r\n", size, _heap.c_str());
+        return false;
+    }
+
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, data.fd, 0);
+    if (addr == MAP_FAILED) {
+        std::printf("map shared internal memory failed\r\n");
+        close(data.fd);
+        return false;
+    }
+
+    _fd = data.fd;
+    _addr = addr;
+    _size = size;
+    return true;
+}
+
+void MemoryGroup::_Free()
+{
+    if (_addr) {
+        munmap(_addr, _size);
+        _addr = nullptr;
+    }
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    _size = 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "rknn_api.h"
+
+
+/* 多个顺序执行的模型共享一块内部工作内存 */
+/* 各上下文以RKNN_FLAG_MEM_ALLOC_OUTSIDE初始化，由组按最大需求从DMA堆分配一次并分别导入，推理时互斥；组须比其中的引擎存活更久 */
+class MemoryGroup
+{
+public:
+    explicit MemoryGroup(const std::string& heap = "/dev/dma_heap/system");
+    ~MemoryGroup();
+
+    void Attach(rknn_context ctx, const rknn_mem_size& size);
+    void Detach(rknn_context ctx);
+
+    /* 推理前调用，加锁并确保共享内存足以覆盖所有成员，失败时返回的锁不持有互斥量 */
+    std::unique_lock<std::mutex> Lock();
+
+    uint64_t GetSharedSize() const;
+    uint64_t GetSeparateSize() const;
+    void Dump() const;
+
+private:
+    struct Member
+    {
+        rknn_context ctx {0};
+        uint32_t internal {0};  // 内部工作内存需求
+        uint32_t weight {0};  // 权重内存，仅用于报告
+        rknn_tensor_mem* mem {nullptr};  // 导入共享内存后的句柄，未绑定时为空
+    };
+
+    std::string _heap;
+    int _fd {-1};  // 共享内存的dma-buf
+    void* _addr {nullptr};
+    uint64_t _size {0};
+    std::vector<Member> _members;
+    mutable std::mutex _mutex;
+
+    bool _Bind();
+    void _Unbind();
+    bool _Allocate(uint64_t size);
+    void _Free();
+};
@@ -0,0 +1,73 @@
+#include <cstdio>
+
+#include "rknn_api.h"
+
+
+/* 主机构建时替代librknnrt，不访问NPU，初始化总是失败，只能以.rec后缀回放录制的输出张量 */
+
+int rknn_init(rknn_context* context, void* model, uint32_t size, uint32_t flag, rknn_init_extend* extend)
+{
+    std::printf("host build has no NPU, use a .rec record instead\r\n");
+    *context = 0;
+    return RKNN_ERR_FAIL;
+}
+
+int rknn_destroy(rknn_context context)
+{
+    return RKNN_SUCC;
+}
+
+int rknn_query(rknn_context context, rknn_query_cmd cmd, void* info, uint32_t size)
+{
+    return RKNN_ERR_FAIL;
+}
+
+int rknn_set_core_mask(rknn_context context, rknn_core_mask core_mask)
+{
+    return RKNN_ERR_FAIL;
+}
+
+int rknn_run(rknn_context context, rknn_run_extend* extend)
+{
+    return RKNN_ERR_FAIL;
+}
+
+rknn_tensor_mem* rknn_create_mem(rknn_context ctx, uint32_t size)
+{
+    return nullptr;
+}
+
+rknn_tensor_mem* rknn_create_mem2(rknn_context ctx, uint64_t size, uint64_t alloc_flags)
+{
+    return nullptr;
+}
+
+rknn_tensor_mem* rknn_create_mem_from_fd(rknn_context ctx, int32_t fd, void* virt_addr, uint32_t size, int32_t offset)
+{
+    return nullptr;
+}
+
+int rknn_destroy_mem(rknn_context ctx, rknn_tensor_mem* mem)
+{
+    return RKNN_SUCC;
+}
+
+int rknn_set_io_mem(rknn_context ctx, rknn_tensor_mem* mem, rknn_tensor_attr* attr)
+{
+    return RKNN_ERR_FAIL;
+}
+
+int rknn_set_internal_mem(rknn_context ctx, rknn_tensor_mem* mem)
+{
+    return RKNN_ERR_FAIL;
+}
+
+int rknn_set_input_shapes(rknn_context ctx, uint32_t n_inputs, rknn_tensor_attr attr[])
+{
+    return RKNN_ERR_FAIL;
+}
+
+int rknn_mem_sync(rknn_context context, rknn_tensor_mem* mem, rknn_mem_sync_mode mode)
+{
+    return RKNN_ERR_FAIL;
+}
@@ -1,32 +1,51 @@
-#include <chrono>
+#include <type_traits>
+#include <algorithm>
 
 #include "yolo_detect.hpp"
 #include "ops.hpp"
 
 
-YoloDetect::YoloDetect(const std::string &modelPath, float scoreThres, float nmsThres) :
-Engine(modelPath), _scoreThres(scoreThres), _nmsThres(nmsThres)
+void DetectionBuffer::ToOriginal(const Transformation& trans)
+{
+    Utils::ToOriginal(trans, _x.data(), _y.data(), _width.data(), _height.data(), Size());
+}
+
+
+YoloDetect::YoloDetect(const std::string &modelPath, float scoreThres, float nmsThres, MemoryMode mode, MemoryGroup* group) :
+Engine(modelPath, mode, group), _head(YoloHead::Params{scoreThres, nmsThres})
 {
 
 }
 
-YoloDetect::ResultPtr YoloDetect::Predict(const void* data, size_t len)
+YoloDetect::~YoloDetect()
 {
-    /* 前处理 */
-    auto t1 = std::chrono::high_resolution_clock::now();
-    AssignInput(data, len);
-    auto t2 = std::chrono::high_resolution_clock::now();
-    _timeCost.preprocess = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+    _StopAsync();
+}
 
-    /* 执行推理 */
-    Inference();
+YoloDetect::ResultPtr YoloDetect::Predict(const void* data, size_t len)
+{
+    return Run(data, len, [&]() {
+        return Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum);
+    });
+}
 
-    /* 后处理 */
-    auto t5 = std::chrono::high_resolution_clock::now();
-    auto result = Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum);
-    auto t6 = std::chrono::high_resolution_clock::now();
-    _timeCost.postprocess = std::chrono::duration_cast<std::chrono::microseconds>(t6 - t5).count();
+void YoloDetect::Predict(const void* data, size_t len, DetectionBuffer& result, const Transformation* trans)
+{
+    /* 后处理，指定变换时一并映射回原图坐标 */
+    Run(data, len, [&]() {
+        Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum, result);
+        if (trans) {
+            result.ToOriginal(*trans);
+        }
+    });
+}
 
+AsyncResult<YoloDetect::ResultPtr> YoloDetect::PredictAsync(const void* data, size_t len)
+{
+    AsyncResult<ResultPtr> result;
+    _Submit([this, data, len, state = result.GetState()](bool run) {
+        state->Set(run ? Predict(data, len) : nullptr);
+    });
     return result;
 }
 
@@ -36,101 +55,277 @@ YoloDetect::ResultPtr YoloDetect::Postprocess(
     const rknn_tensor_attr* nativeAttr,
     size_t num
 )
+{
+    DetectionBuffer buffer;
+    _head.Decode(*this, {output, attr, nativeAttr, num}, buffer);
+
+    ResultPtr result = std::make_unique<Result>();
+    result->reserve(buffer.Size());
+    for (auto det : buffer) {
+        result->push_back(det);
+    }
+    return result;
+}
+
+void YoloDetect::Postprocess(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    size_t num,
+    DetectionBuffer& result
+)
+{
+    _head.Decode(*this, {output, attr, nativeAttr, num}, result);
+}
+
+bool YoloDetect::SetClassFilter(const ClassFilter& filter)
+{
+    return _head.SetClassFilter(filter);
+}
+
+const YoloDetect::DecodeStats& YoloDetect::GetDecodeStats() const
+{
+    return _head.GetDecodeStats();
+}
+
+void YoloDetect::_Decode(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    uint32_t bunch,
+    uint32_t size,
+    Candidates &candidates,
+    uint32_t extra)
+{
+    _head.DecodeCandidates(*this, {output, attr, nativeAttr, bunch * size}, bunch, size, candidates, extra);
+}
+
+
+YoloHead::Result YoloHead::Decode(Engine& engine)
+{
+    DetectionBuffer result;
+    Decode(engine, engine.GetOutputs(), result);
+    return result;
+}
+
+void YoloHead::Decode(Engine& engine, const Engine::Outputs& outputs, DetectionBuffer& result)
 {
     /* 输出包含6个张量，一共3组，每组2个，每组包含1个box和1个score输出 */
     /* (1, 64, 80, 80) (1, 80, 80, 80) (1, 64, 40, 40) (1, 80, 40, 40) (1, 64, 20, 20) (1, 80, 20, 20) */
+    /* 部分模型每组额外输出1个score_sum，共9个张量 */
+    /* (1, 64, 80, 80) (1, 80, 80, 80) (1, 1, 80, 80) ... */
+
+    uint32_t size = BranchSize(outputs.attr, outputs.num);  // 每组张量数
+    _scratch.Clear();
+    DecodeCandidates(engine, outputs, outputs.num / size, size, _scratch);
 
-    std::vector<Rect2f> boxes;  // 检测框
-    std::vector<float> scores;  // 得分
-    std::vector<int> classes;  // 类别
+    /* NMS */
+    auto nmsResult = Utils::NMS(_scratch.boxes, _scratch.scores, _scratch.classes, _params.nmsThres);
+
+    /* 输出结果 */
+    result.Clear();
+    result.Reserve(nmsResult.size());
+    for (auto &i : nmsResult) {
+        result.Push(_scratch.classes[i], _scratch.scores[i], _scratch.boxes[i]);
+    }
+}
+
+bool YoloHead::SetClassFilter(const ClassFilter& filter)
+{
+    if (!filter.thresholds.empty() && filter.thresholds.size() != filter.classes.size()) {
+        std::printf("class filter has %ld classes but %ld thresholds\r\n", filter.classes.size(), filter.thresholds.size());
+        return false;
+    }
+    for (auto& c : filter.classes) {
+        if (c < 0) {
+            std::printf("invalid class %d in filter\r\n", c);
+            return false;
+        }
+    }
+
+    _filter = filter;
+    return true;
+}
+
+void YoloHead::DecodeCandidates(
+    Engine& engine,
+    const Engine::Outputs& outputs,
+    uint32_t bunch,
+    uint32_t size,
+    Candidates &candidates,
+    uint32_t extra)
+{
+    const rknn_tensor_mem* const* output = outputs.mem;
+    const rknn_tensor_attr* attr = outputs.attr;
+    const rknn_tensor_attr* nativeAttr = outputs.nativeAttr;
     auto type = attr[0].type;  // 数据类型
-    uint32_t bunch = num / 2;  // 组数
+    bool hasSum = size - extra >= 3 && attr[2].dims[1] == 1;  // 除附加张量外每组第3个张量为单通道时为score_sum
+
+    _decodeStats = DecodeStats();
 
     /* 遍历所有尺度输出 */
     for (uint32_t i = 0; i < bunch; i++) {
         if (type == RKNN_TENSOR_INT8) {
-            _DecodeBunch<int8_t>(&output[2*i], &attr[2*i], &nativeAttr[2*i], boxes, scores, classes);
+            _DecodeBunch<int8_t>(engine, &output[size*i], &attr[size*i], &nativeAttr[size*i], hasSum, i, candidates);
         } else if (type == RKNN_TENSOR_UINT8) {
-            _DecodeBunch<uint8_t>(&output[2*i], &attr[2*i], &nativeAttr[2*i], boxes, scores, classes);
+            _DecodeBunch<uint8_t>(engine, &output[size*i], &attr[size*i], &nativeAttr[size*i], hasSum, i, candidates);
         } else if (type == RKNN_TENSOR_FLOAT32) {
-            _DecodeBunch<float>(&output[2*i], &attr[2*i], &nativeAttr[2*i], boxes, scores, classes);
+            _DecodeBunch<float>(engine, &output[size*i], &attr[size*i], &nativeAttr[size*i], hasSum, i, candidates);
+        } else if (type == RKNN_TENSOR_FLOAT16) {
+            _DecodeBunch<Half>(engine, &output[size*i], &attr[size*i], &nativeAttr[size*i], hasSum, i, candidates);
         }
     }
+}
 
-    /* NMS */
-    auto nmsResult = Utils::NMS(boxes, scores, classes, _nmsThres);
-
-    /* 输出结果 */
-    ResultPtr result = std::make_unique<Result>();
-    for (auto &i : nmsResult) {
-        result->emplace_back(
-            Detection(
-                classes[i],
-                scores[i],
-                boxes[i]
-            )
-        );
+uint32_t YoloHead::BranchSize(const rknn_tensor_attr* attr, size_t num)
+{
+    /* 第3个张量为单通道且与box同尺度时，判定为box/score/score_sum布局 */
+    if (num >= 3 && num % 3 == 0 &&
+        attr[2].dims[1] == 1 &&
+        attr[2].dims[2] == attr[0].dims[2] &&
+        attr[2].dims[3] == attr[0].dims[3]) {
+        return 3;
     }
-
-    return result;
+    return 2;
 }
 
 template<typename T>
-void YoloDetect::_DecodeBunch(
+void YoloHead::_DecodeBunch(
+    Engine& engine,
     const rknn_tensor_mem* const* output,
     const rknn_tensor_attr* attr,
     const rknn_tensor_attr* nativeAttr,
-    std::vector<Rect2f> &boxes,
-    std::vector<float> &scores,
-    std::vector<int> &classes)
+    bool hasSum,
+    uint32_t branch,
+    Candidates &candidates)
 {
     auto boxTensorShape = attr[0].dims;  // box矩阵shape
     uint32_t gridH = boxTensorShape[2];
     uint32_t gridW = boxTensorShape[3];
     uint32_t total = gridH * gridW;  /* box总数 */
-    float scale = GetInputSize().width / 1.f / gridW;  // 缩放比例
+    float scale = engine.GetInputSize().width / 1.f / gridW;  // 缩放比例
     uint32_t cls = attr[1].dims[1];  /* 类别数 */
-    const T* boxTensor = static_cast<const T*>(output[0]->virt_addr);  /* (1, 4*dflLen, h, w) */
-    const T* scoreTensor = static_cast<const T*>(output[1]->virt_addr);  /* (1, classes, h, w) */
     Rknn::Quantization boxQuant {attr[0].scale, attr[0].zp};  /* box矩阵量化参数 */
     Rknn::Quantization scoreQuant {attr[1].scale, attr[1].zp};  /* 分数量化参数 */
     T scoreThreshold = Rknn::Quantization::Quantize<T>(
-        _scoreThres,
+        _params.scoreThres,
         scoreQuant.scale,
         scoreQuant.zp
     );  /* 量化后的分数阈值 */
 
-    /* NC1HWC2转NCHW */
-    if (nativeAttr[0].fmt == RKNN_TENSOR_NC1HWC2) {
-        uint32_t boxTensorSize = output[0]->size;
-        T *convertedBoxTensor = new T[boxTensorSize];
-        Utils::NC1HWC2ToNCHW(boxTensor, convertedBoxTensor, &nativeAttr[0], &attr[0]);
-        boxTensor = convertedBoxTensor;
-    }
-    if (nativeAttr[1].fmt == RKNN_TENSOR_NC1HWC2) {
-        uint32_t scoreTensorSize = output[1]->size;
-        T *convertedScoreTensor = new T[scoreTensorSize];
-        Utils::NC1HWC2ToNCHW(scoreTensor, convertedScoreTensor, &nativeAttr[1], &attr[1]);
-        scoreTensor = convertedScoreTensor;
+    /* 类别子集及各自阈值，每个张量量化一次，超出类别数的类别忽略 */
+    std::vector<uint32_t> subset;
+    std::vector<T> subsetThreshold;
+    float minThres = _params.scoreThres;  // score_sum只能以最低的类别阈值判定
+    for (size_t k = 0; k < _filter.classes.size(); k++) {
+        if (static_cast<uint32_t>(_filter.classes[k]) >= cls) {
+            continue;
+        }
+        float thres = _filter.thresholds.empty() ? _params.scoreThres : _filter.thresholds[k];
+        subset.push_back(_filter.classes[k]);
+        subsetThreshold.push_back(Rknn::Quantization::Quantize<T>(thres, scoreQuant.scale, scoreQuant.zp));
+        minThres = subset.size() == 1 ? thres : std::min(minThres, thres);
     }
+    bool filtered = !_filter.classes.empty();
+
+    T sumThreshold = hasSum ? Rknn::Quantization::Quantize<T>(
+        minThres,
+        attr[2].scale,
+        attr[2].zp
+    ) : T();  /* 量化后的score_sum阈值 */
+
+    /* 张量按需获取：首次访问时同步缓存并转换排布，score_sum先行，box张量只在出现候选框后才读取 */
+    T* converted[3] = {nullptr, nullptr, nullptr};
+    auto acquire = [&](uint32_t index) -> const T* {
+        engine.SyncOutput(output[index]);
+        const T* tensor = static_cast<const T*>(output[index]->virt_addr);
+        if (nativeAttr[index].fmt == RKNN_TENSOR_NC1HWC2) {
+            /* NC1HWC2转NCHW */
+            converted[index] = new T[output[index]->size];
+            Utils::NC1HWC2ToNCHW(tensor, converted[index], &nativeAttr[index], &attr[index]);
+            tensor = converted[index];
+        }
+        return tensor;
+    };
+    const T* sumTensor = hasSum ? acquire(2) : nullptr;  /* (1, 1, h, w) */
+    const T* scoreTensor = hasSum ? nullptr : acquire(1);  /* (1, classes, h, w) */
+    const T* boxTensor = nullptr;  /* (1, 4*dflLen, h, w) */
+
+    _decodeStats.cells += total;
+
+    std::vector<float> dfl;  // 单个框的DFL分布
+    dfl.reserve(boxTensorShape[1]);
+
+    /* 半精度输出整行并行求最高分类别，直接在fp16上比较，不做整张量转换 */
+    constexpr bool halfType = std::is_same_v<T, Half>;
+    bool rowArgmax = halfType && !filtered;
+    std::vector<T> rowMax(rowArgmax ? gridW : 0);
+    std::vector<uint16_t> rowIndex(rowArgmax ? gridW : 0);
 
     /* 遍历所有box */
     for (uint32_t i = 0; i < gridH; i++) {
+        if constexpr (halfType) {
+            if (rowArgmax) {
+                /* score_sum先行：整行都低于阈值时跳过该行，不读取分数张量 */
+                bool any = !hasSum;
+                for (uint32_t j = 0; j < gridW && !any; j++) {
+                    any = !(sumTensor[i * gridW + j] < sumThreshold);
+                }
+                if (!any) {
+                    _decodeStats.skipped += gridW;
+                    continue;
+                }
+                if (scoreTensor == nullptr) {
+                    scoreTensor = acquire(1);
+                }
+                Utils::ArgmaxHalf(scoreTensor + i * gridW, total, cls, gridW, rowMax.data(), rowIndex.data());
+            }
+        }
         for (uint32_t j = 0; j < gridW; j++) {
+            /* 所有类别得分之和低于阈值时，最高分必然也低于阈值，跳过类别遍历 */
+            if (hasSum && sumTensor[i * gridW + j] < sumThreshold) {
+                _decodeStats.skipped++;
+                continue;
+            }
+
             /* 寻找最高得分类别 */
+            if (scoreTensor == nullptr) {
+                scoreTensor = acquire(1);
+            }
             uint32_t maxIndex = 0;
             T maxScore = scoreTensor[i * gridW + j];
-            for (uint32_t k = 0, off = i * gridW + j; k < cls; k++, off += total) {
-                if (scoreTensor[off] > maxScore) {
-                    maxIndex = k;
-                    maxScore = scoreTensor[off];
+            bool pass = false;
+            if (filtered) {
+                /* 只访问选中类别的平面，取超过各自阈值的最高分类别 */
+                for (size_t k = 0; k < subset.size(); k++) {
+                    T v = scoreTensor[subset[k] * total + i * gridW + j];
+                    if (v > subsetThreshold[k] && (!pass || v > maxScore)) {
+                        maxIndex = subset[k];
+                        maxScore = v;
+                        pass = true;
+                    }
+                }
+            } else if (rowArgmax) {
+                maxIndex = rowIndex[j];
+                maxScore = rowMax[j];
+                pass = maxScore > scoreThreshold;
+            } else {
+                for (uint32_t k = 0, off = i * gridW + j; k < cls; k++, off += total) {
+                    if (scoreTensor[off] > maxScore) {
+                        maxIndex = k;
+                        maxScore = scoreTensor[off];
+                    }
                 }
+                pass = maxScore > scoreThreshold;
             }
 
             /* 过滤低分框 */
-            if (maxScore > scoreThreshold) {
+            if (pass) {
                 /* 计算box坐标 */
-                std::vector<float> dfl;
+                if (boxTensor == nullptr) {
+                    boxTensor = acquire(0);
+                }
+                dfl.clear();
                 for (uint32_t k = 0, off = i * gridW + j; k < boxTensorShape[1]; k++, off += total) {
                     dfl.push_back(boxQuant.Dequantize(boxTensor[off]));
                 }
@@ -144,22 +339,19 @@ void YoloDetect::_DecodeBunch(
                 w = x2 - x1;
                 h = y2 - y1;
 
-                boxes.emplace_back(x1, y1, w, h);
-                scores.push_back(scoreQuant.Dequantize(maxScore));
-                classes.push_back(maxIndex);
+                candidates.boxes.emplace_back(x1, y1, w, h);
+                candidates.scores.push_back(scoreQuant.Dequantize(maxScore));
+                candidates.classes.push_back(maxIndex);
+                candidates.branches.push_back(branch);
+                candidates.cells.push_back(i * gridW + j);
 
-                // std::printf("%d @ %.2f [%.2f %.2f %.2f %.2f]\r\n", classes.back(), scores.back(), x1, y1, w, h);
+                // std::printf("%d @ %.2f [%.2f %.2f %.2f %.2f]\r\n", candidates.classes.back(), candidates.scores.back(), x1, y1, w, h);
             }
         }
     }
 
     /* 释放资源 */
-    if (nativeAttr[0].fmt == RKNN_TENSOR_NC1HWC2) {
-        delete[] boxTensor;
-        boxTensor = nullptr;
-    }
-    if (nativeAttr[1].fmt == RKNN_TENSOR_NC1HWC2) {
-        delete[] scoreTensor;
-        scoreTensor = nullptr;
+    for (auto &&tensor : converted) {
+        delete[] tensor;
     }
 }
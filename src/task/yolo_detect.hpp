@@ -2,9 +2,11 @@
 
 #include <vector>
 #include <memory>
+#include <span>
 
 #include "types.hpp"
 #include "engine.hpp"
+#include "async_result.hpp"
 
 
 struct Detection
@@ -19,15 +21,182 @@ struct Detection
 };
 
 
+/* SoA排布的检测结果，由调用方持有并跨帧复用，避免每帧分配 */
+class DetectionBuffer
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const DetectionBuffer* buffer, size_t index) :
+        _buffer(buffer), _index(index) {}
+
+        Detection operator*() const { return (*_buffer)[_index]; }
+        Iterator& operator++() { _index++; return *this; }
+        bool operator!=(const Iterator& other) const { return _index != other._index; }
+
+    private:
+        const DetectionBuffer* _buffer;
+        size_t _index;
+    };
+
+    void Clear()
+    {
+        _ids.clear();
+        _scores.clear();
+        _x.clear();
+        _y.clear();
+        _width.clear();
+        _height.clear();
+    }
+
+    void Reserve(size_t n)
+    {
+        _ids.reserve(n);
+        _scores.reserve(n);
+        _x.reserve(n);
+        _y.reserve(n);
+        _width.reserve(n);
+        _height.reserve(n);
+    }
+
+    void Push(int id, float score, const Rect2f& box)
+    {
+        _ids.push_back(id);
+        _scores.push_back(score);
+        _x.push_back(box.x);
+        _y.push_back(box.y);
+        _width.push_back(box.width);
+        _height.push_back(box.height);
+    }
+
+    size_t Size() const { return _ids.size(); }
+    bool Empty() const { return _ids.empty(); }
+
+    std::span<const int32_t> Ids() const { return _ids; }
+    std::span<const float> Scores() const { return _scores; }
+    std::span<const float> X() const { return _x; }
+    std::span<const float> Y() const { return _y; }
+    std::span<const float> Width() const { return _width; }
+    std::span<const float> Height() const { return _height; }
+
+    Detection operator[](size_t i) const
+    {
+        return {_ids[i], _scores[i], {_x[i], _y[i], _width[i], _height[i]}};
+    }
+
+    Iterator begin() const { return {this, 0}; }
+    Iterator end() const { return {this, Size()}; }
+
+    /* 所有框映射回原图坐标 */
+    void ToOriginal(const Transformation& trans);
+
+private:
+    std::vector<int32_t> _ids;
+    std::vector<float> _scores;
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _width;
+    std::vector<float> _height;
+};
+
+
+/* YOLOv8检测解码头，可挂接到任意引擎，也是YoloDetect及其派生任务的候选框解码实现 */
+class YoloHead
+{
+public:
+    struct Params
+    {
+        float scoreThres {0.25f};
+        float nmsThres {0.7f};
+    };
+    using Result = DetectionBuffer;
+
+    /* 类别筛选，classes为空时保留全部类别；thresholds与classes一一对应，为空时使用全局分数阈值 */
+    struct ClassFilter
+    {
+        std::vector<int> classes;
+        std::vector<float> thresholds;
+    };
+
+    struct DecodeStats
+    {
+        uint64_t cells {0};  // 遍历的网格数
+        uint64_t skipped {0};  // 被score_sum提前拒绝的网格数
+    };
+
+    /* 解码得到的候选框，cells记录候选框所在组及网格下标，供派生任务提取附加输出 */
+    struct Candidates
+    {
+        std::vector<Rect2f> boxes;  // 检测框
+        std::vector<float> scores;  // 得分
+        std::vector<int> classes;  // 类别
+        std::vector<uint32_t> branches;  // 所在组
+        std::vector<uint32_t> cells;  // 所在网格下标
+
+        void Clear()
+        {
+            boxes.clear();
+            scores.clear();
+            classes.clear();
+            branches.clear();
+            cells.clear();
+        }
+    };
+
+    YoloHead() = default;
+    explicit YoloHead(const Params& params) : _params(params) {}
+
+    Result Decode(Engine& engine);
+    void Decode(Engine& engine, const Engine::Outputs& outputs, DetectionBuffer& result);
+    /* 解码NMS前的候选框，bunch为组数，size为每组张量数，extra为每组末尾的附加张量数(关键点、角度等) */
+    /* 附加张量为单通道时不会被误判为score_sum */
+    void DecodeCandidates(Engine& engine,
+                          const Engine::Outputs& outputs,
+                          uint32_t bunch,
+                          uint32_t size,
+                          Candidates& candidates,
+                          uint32_t extra = 0);
+
+    bool SetClassFilter(const ClassFilter& filter);
+    const DecodeStats& GetDecodeStats() const { return _decodeStats; }
+    const Params& GetParams() const { return _params; }
+
+    static uint32_t BranchSize(const rknn_tensor_attr* attr, size_t num);
+
+private:
+    Params _params;
+    ClassFilter _filter;
+    DecodeStats _decodeStats;
+    Candidates _scratch;  // 复用的候选框缓冲
+
+    template<typename T>
+    void _DecodeBunch(Engine& engine,
+                      const rknn_tensor_mem* const* output,
+                      const rknn_tensor_attr* attr,
+                      const rknn_tensor_attr* nativeAttr,
+                      bool hasSum,
+                      uint32_t branch,
+                      Candidates &candidates);
+};
+
+
 class YoloDetect : public Engine
 {
 public:
     using Result = std::vector<Detection>;
     using ResultPtr = std::unique_ptr<Result>;
+    using ClassFilter = YoloHead::ClassFilter;
+    using DecodeStats = YoloHead::DecodeStats;
 
-    explicit YoloDetect(const std::string &modelPath, float scoreThres = 0.25f, float nmsThres = 0.7f);
+    explicit YoloDetect(const std::string &modelPath, float scoreThres = 0.25f, float nmsThres = 0.7f, MemoryMode mode = MemoryMode::Default, MemoryGroup* group = nullptr);
+
+    ~YoloDetect();
 
     ResultPtr Predict(const void* data, size_t len);
+    void Predict(const void* data, size_t len, DetectionBuffer& result, const Transformation* trans = nullptr);
+    /* 提交到引擎的执行线程后立即返回，完成前data须保持有效；引擎析构时未执行的请求以空指针完成 */
+    AsyncResult<ResultPtr> PredictAsync(const void* data, size_t len);
 
     ResultPtr Postprocess(
         const rknn_tensor_mem* const* output,
@@ -35,16 +204,27 @@ public:
         const rknn_tensor_attr* nativeAttr,
         size_t num
     );
+    void Postprocess(
+        const rknn_tensor_mem* const* output,
+        const rknn_tensor_attr* attr,
+        const rknn_tensor_attr* nativeAttr,
+        size_t num,
+        DetectionBuffer& result
+    );
 
-private:
-    float _scoreThres;
-    float _nmsThres;
+    bool SetClassFilter(const ClassFilter& filter);
+    const DecodeStats& GetDecodeStats() const;
 
-    template<typename T>
-    void _DecodeBunch(const rknn_tensor_mem* const* output,
-                      const rknn_tensor_attr* attr,
-                      const rknn_tensor_attr* nativeAttr,
-                      std::vector<Rect2f> &boxes,
-                      std::vector<float> &scores,
-                      std::vector<int> &classes);
+protected:
+    using Candidates = YoloHead::Candidates;
+
+    YoloHead _head;
+
+    void _Decode(const rknn_tensor_mem* const* output,
+                 const rknn_tensor_attr* attr,
+                 const rknn_tensor_attr* nativeAttr,
+                 uint32_t bunch,
+                 uint32_t size,
+                 Candidates &candidates,
+                 uint32_t extra = 0);
 };
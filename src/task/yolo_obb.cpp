@@ -0,0 +1,134 @@
+#include <cmath>
+#include <numbers>
+
+#include "yolo_obb.hpp"
+
+
+ObbHead::Result ObbHead::Decode(Engine& engine)
+{
+    Result result;
+    Decode(engine, engine.GetOutputs(), result);
+    return result;
+}
+
+void ObbHead::Decode(Engine& engine, const Engine::Outputs& outputs, Result& result)
+{
+    /* 输出为3组，每组包含box、score、score_sum(可选)、angle，angle为未解码的单通道原始输出 */
+    /* (1, 64, 128, 128) (1, 15, 128, 128) (1, 1, 128, 128) (1, 1, 128, 128) ... */
+
+    const rknn_tensor_attr* attr = outputs.attr;
+    uint32_t size = outputs.num % 4 == 0 && attr[2].dims[1] == 1 && attr[3].dims[1] == 1 ? 4 : 3;  // 每组张量数
+    _scratch.Clear();
+    _detect.DecodeCandidates(engine, outputs, outputs.num / size, size, _scratch, 1);
+
+    /* NMS前为所有候选框解码角度 */
+    auto type = attr[size - 1].type;
+    if (type == RKNN_TENSOR_INT8) {
+        _DecodeAngles<int8_t>(engine, outputs, size);
+    } else if (type == RKNN_TENSOR_UINT8) {
+        _DecodeAngles<uint8_t>(engine, outputs, size);
+    } else if (type == RKNN_TENSOR_FLOAT32) {
+        _DecodeAngles<float>(engine, outputs, size);
+    } else if (type == RKNN_TENSOR_FLOAT16) {
+        _DecodeAngles<Half>(engine, outputs, size);
+    } else {
+        _boxes.clear();
+    }
+
+    /* 旋转框NMS */
+    _nmsStats = Utils::RotatedNMSStats();
+    auto nmsResult = Utils::RotatedNMS(_boxes, _scratch.scores, _scratch.classes, GetParams().nmsThres, &_nmsStats);
+
+    /* 输出结果，统一为宽不小于高、角度在[0, π)内 */
+    result.clear();
+    result.reserve(nmsResult.size());
+    for (auto &i : nmsResult) {
+        RotatedRect box = _boxes[i];
+        if (box.width < box.height) {
+            std::swap(box.width, box.height);
+            box.angle += std::numbers::pi_v<float> / 2.f;
+        }
+        box.angle = std::fmod(box.angle, std::numbers::pi_v<float>);
+        if (box.angle < 0.f) {
+            box.angle += std::numbers::pi_v<float>;
+        }
+        result.emplace_back(_scratch.classes[i], _scratch.scores[i], box);
+    }
+}
+
+template<typename T>
+void ObbHead::_DecodeAngles(Engine& engine, const Engine::Outputs& outputs, uint32_t size)
+{
+    const rknn_tensor_mem* const* output = outputs.mem;
+    const rknn_tensor_attr* attr = outputs.attr;
+    const rknn_tensor_attr* nativeAttr = outputs.nativeAttr;
+    float inputWidth = engine.GetInputSize().width;
+
+    _boxes.resize(_scratch.boxes.size());
+    for (size_t n = 0; n < _scratch.boxes.size(); n++) {
+        uint32_t index = _scratch.branches[n] * size + size - 1;  /* 该组角度张量下标 */
+        uint32_t gridW = attr[index].dims[3];
+        float scale = inputWidth / gridW;  // 缩放比例
+        uint32_t i = _scratch.cells[n] / gridW;
+        uint32_t j = _scratch.cells[n] % gridW;
+        Rknn::Quantization quant {attr[index].scale, attr[index].zp};  /* 角度量化参数 */
+        engine.SyncOutput(output[index]);
+        T raw;
+        Utils::GatherChannels(static_cast<const T*>(output[index]->virt_addr), &raw,
+                              _scratch.cells[n], &nativeAttr[index], &attr[index]);
+
+        /* 角度为 (sigmoid(x) - 0.25) * π */
+        float angle = (1.f / (1.f + std::exp(-quant.Dequantize(raw))) - 0.25f) * std::numbers::pi_v<float>;
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+
+        /* DFL给出的是旋转坐标系下的四边距离，中心相对网格中心的偏移需按角度旋转回图像坐标 */
+        const Rect2f &box = _scratch.boxes[n];
+        float ax = (j + 0.5f) * scale;
+        float ay = (i + 0.5f) * scale;
+        float dx = box.x + box.width / 2.f - ax;
+        float dy = box.y + box.height / 2.f - ay;
+        _boxes[n] = {ax + dx * c - dy * s, ay + dx * s + dy * c, box.width, box.height, angle};
+    }
+}
+
+
+YoloObb::YoloObb(const std::string &modelPath, float scoreThres, float nmsThres, MemoryMode mode, MemoryGroup* group) :
+Engine(modelPath, mode, group), _head(ObbHead::Params{scoreThres, nmsThres})
+{
+
+}
+
+YoloObb::ResultPtr YoloObb::Predict(const void* data, size_t len)
+{
+    return Run(data, len, [&]() {
+        return Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum);
+    });
+}
+
+YoloObb::ResultPtr YoloObb::Postprocess(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    size_t num
+)
+{
+    ResultPtr result = std::make_unique<Result>();
+    _head.Decode(*this, {output, attr, nativeAttr, num}, *result);
+    return result;
+}
+
+bool YoloObb::SetClassFilter(const ClassFilter& filter)
+{
+    return _head.SetClassFilter(filter);
+}
+
+const YoloObb::DecodeStats& YoloObb::GetDecodeStats() const
+{
+    return _head.GetDecodeStats();
+}
+
+const Utils::RotatedNMSStats& YoloObb::GetNMSStats() const
+{
+    return _head.GetNMSStats();
+}
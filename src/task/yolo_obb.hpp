@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "types.hpp"
+#include "ops.hpp"
+#include "yolo_detect.hpp"
+
+
+struct ObbDetection
+{
+    int id {-1};
+    float score {0.f};
+    RotatedRect box;  // 宽不小于高，角度在[0, π)内
+
+    ObbDetection() = default;
+    ObbDetection(int id, float score, const RotatedRect& box) :
+    id(id), score(score), box(box) {}
+};
+
+
+/* 旋转框检测解码头(YOLOv8-OBB)，复用YoloHead解码DFL候选框，再解码角度输出并以旋转框IoU做NMS */
+class ObbHead
+{
+public:
+    using Params = YoloHead::Params;
+    using Result = std::vector<ObbDetection>;
+    using ClassFilter = YoloHead::ClassFilter;
+    using DecodeStats = YoloHead::DecodeStats;
+
+    ObbHead() = default;
+    explicit ObbHead(const Params& params) : _detect(params) {}
+
+    Result Decode(Engine& engine);
+    void Decode(Engine& engine, const Engine::Outputs& outputs, Result& result);
+
+    bool SetClassFilter(const ClassFilter& filter) { return _detect.SetClassFilter(filter); }
+    const DecodeStats& GetDecodeStats() const { return _detect.GetDecodeStats(); }
+    const Utils::RotatedNMSStats& GetNMSStats() const { return _nmsStats; }
+    const Params& GetParams() const { return _detect.GetParams(); }
+
+private:
+    YoloHead _detect;
+    YoloHead::Candidates _scratch;  // 复用的候选框缓冲
+    std::vector<RotatedRect> _boxes;  // 复用的旋转框缓冲
+    Utils::RotatedNMSStats _nmsStats;
+
+    template<typename T>
+    void _DecodeAngles(Engine& engine, const Engine::Outputs& outputs, uint32_t size);
+};
+
+
+/* 旋转框检测模型，后处理由ObbHead实现；不提供轴对齐框的Predict，避免丢失角度 */
+class YoloObb : public Engine
+{
+public:
+    using Result = ObbHead::Result;
+    using ResultPtr = std::unique_ptr<Result>;
+    using ClassFilter = ObbHead::ClassFilter;
+    using DecodeStats = ObbHead::DecodeStats;
+
+    explicit YoloObb(const std::string &modelPath, float scoreThres = 0.25f, float nmsThres = 0.7f, MemoryMode mode = MemoryMode::Default, MemoryGroup* group = nullptr);
+
+    ResultPtr Predict(const void* data, size_t len);
+
+    ResultPtr Postprocess(
+        const rknn_tensor_mem* const* output,
+        const rknn_tensor_attr* attr,
+        const rknn_tensor_attr* nativeAttr,
+        size_t num
+    );
+
+    bool SetClassFilter(const ClassFilter& filter);
+    const DecodeStats& GetDecodeStats() const;
+    const Utils::RotatedNMSStats& GetNMSStats() const;
+
+private:
+    ObbHead _head;
+};
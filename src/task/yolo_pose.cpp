@@ -0,0 +1,120 @@
+#include <cmath>
+
+#include "yolo_pose.hpp"
+#include "ops.hpp"
+
+
+void Keypoints::ToOriginal(const Transformation& trans)
+{
+    for (size_t i = 0; i < x.size(); i++) {
+        trans.ToOriginal(x[i], y[i]);
+    }
+}
+
+void Poses::ToOriginal(Transformation& trans)
+{
+    for (auto &obj : objects) {
+        trans.ToOriginal(obj.box);
+    }
+    keypoints.ToOriginal(trans);
+}
+
+
+YoloPose::YoloPose(const std::string &modelPath, float scoreThres, float nmsThres, MemoryMode mode, MemoryGroup* group) :
+YoloDetect(modelPath, scoreThres, nmsThres, mode, group)
+{
+
+}
+
+YoloPose::ResultPtr YoloPose::Predict(const void* data, size_t len)
+{
+    return Run(data, len, [&]() {
+        return Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum);
+    });
+}
+
+YoloPose::ResultPtr YoloPose::Postprocess(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    size_t num
+)
+{
+    /* 输出为3组，每组包含box、score、score_sum(可选)、关键点，关键点为未解码的原始输出 */
+    /* (1, 64, 80, 80) (1, 1, 80, 80) (1, 1, 80, 80) (1, 51, 80, 80) ... */
+
+    uint32_t size = num % 4 == 0 && attr[2].dims[1] == 1 ? 4 : 3;  // 每组张量数
+    Candidates candidates;
+    _Decode(output, attr, nativeAttr, num / size, size, candidates);
+
+    /* NMS */
+    auto nmsResult = Utils::NMS(candidates.boxes, candidates.scores, candidates.classes, _head.GetParams().nmsThres);
+
+    /* 输出结果 */
+    ResultPtr result = std::make_unique<Result>();
+    result->objects.reserve(nmsResult.size());
+    for (auto &i : nmsResult) {
+        result->objects.emplace_back(
+            Detection(
+                candidates.classes[i],
+                candidates.scores[i],
+                candidates.boxes[i]
+            )
+        );
+    }
+
+    /* 仅对NMS保留下来的检测框提取关键点 */
+    auto type = attr[size - 1].type;
+    if (type == RKNN_TENSOR_INT8) {
+        _GatherKeypoints<int8_t>(output, attr, nativeAttr, size, candidates, nmsResult, result->keypoints);
+    } else if (type == RKNN_TENSOR_UINT8) {
+        _GatherKeypoints<uint8_t>(output, attr, nativeAttr, size, candidates, nmsResult, result->keypoints);
+    } else if (type == RKNN_TENSOR_FLOAT32) {
+        _GatherKeypoints<float>(output, attr, nativeAttr, size, candidates, nmsResult, result->keypoints);
+    } else if (type == RKNN_TENSOR_FLOAT16) {
+        _GatherKeypoints<Half>(output, attr, nativeAttr, size, candidates, nmsResult, result->keypoints);
+    }
+
+    return result;
+}
+
+template<typename T>
+void YoloPose::_GatherKeypoints(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    uint32_t size,
+    const Candidates &candidates,
+    const std::vector<int> &keep,
+    Keypoints &keypoints)
+{
+    uint32_t channels = attr[size - 1].dims[1];  /* 3 * 关键点数 */
+    keypoints.num = channels / 3;
+    keypoints.x.resize(keep.size() * keypoints.num);
+    keypoints.y.resize(keep.size() * keypoints.num);
+    keypoints.visibility.resize(keep.size() * keypoints.num);
+
+    std::vector<T> raw(channels);  // 单个网格的关键点原始输出
+    for (size_t n = 0; n < keep.size(); n++) {
+        int idx = keep[n];
+        uint32_t index = candidates.branches[idx] * size + size - 1;  /* 该组关键点张量下标 */
+        uint32_t gridW = attr[index].dims[3];
+        float scale = GetInputSize().width / 1.f / gridW;  // 缩放比例
+        uint32_t i = candidates.cells[idx] / gridW;
+        uint32_t j = candidates.cells[idx] % gridW;
+        Rknn::Quantization quant {attr[index].scale, attr[index].zp};  /* 关键点量化参数 */
+        SyncOutput(output[index]);
+        Utils::GatherChannels(static_cast<const T*>(output[index]->virt_addr), raw.data(),
+                              candidates.cells[idx], &nativeAttr[index], &attr[index]);
+
+        /* 每个关键点依次为x、y、可见度 */
+        float* xp = &keypoints.x[n * keypoints.num];
+        float* yp = &keypoints.y[n * keypoints.num];
+        float* vp = &keypoints.visibility[n * keypoints.num];
+        for (uint32_t k = 0; k < keypoints.num; k++) {
+            xp[k] = (quant.Dequantize(raw[3 * k]) * 2.f + j) * scale;
+            yp[k] = (quant.Dequantize(raw[3 * k + 1]) * 2.f + i) * scale;
+            vp[k] = 1.f / (1.f + std::exp(-quant.Dequantize(raw[3 * k + 2])));
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "types.hpp"
+#include "yolo_detect.hpp"
+
+
+/* 关键点SoA缓冲，第i个目标的第k个关键点位于下标 i * num + k */
+struct Keypoints
+{
+    uint32_t num {0};  // 每个目标的关键点数
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> visibility;
+
+    void ToOriginal(const Transformation& trans);
+};
+
+
+struct Poses
+{
+    YoloDetect::Result objects;
+    Keypoints keypoints;
+
+    void ToOriginal(Transformation& trans);
+};
+
+
+class YoloPose : public YoloDetect
+{
+public:
+    using Result = Poses;
+    using ResultPtr = std::unique_ptr<Result>;
+
+    explicit YoloPose(const std::string &modelPath, float scoreThres = 0.25f, float nmsThres = 0.7f, MemoryMode mode = MemoryMode::Default, MemoryGroup* group = nullptr);
+
+    ResultPtr Predict(const void* data, size_t len);
+
+    ResultPtr Postprocess(
+        const rknn_tensor_mem* const* output,
+        const rknn_tensor_attr* attr,
+        const rknn_tensor_attr* nativeAttr,
+        size_t num
+    );
+
+private:
+    template<typename T>
+    void _GatherKeypoints(const rknn_tensor_mem* const* output,
+                          const rknn_tensor_attr* attr,
+                          const rknn_tensor_attr* nativeAttr,
+                          uint32_t size,
+                          const Candidates &candidates,
+                          const std::vector<int> &keep,
+                          Keypoints &keypoints);
+};
@@ -0,0 +1,264 @@
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+#ifdef WITH_NEON
+    #include "arm_neon.h"
+#endif
+
+#include "yolo_segment.hpp"
+#include "ops.hpp"
+
+
+/* 计算一行原型与掩码系数的点积，int8直接在量化域累加 */
+static void MaskRowInt8(const int8_t* proto, uint32_t total, const int16_t* coef, uint32_t nm, int16_t zp, int32_t* acc, int n)
+{
+    std::fill(acc, acc + n, 0);
+    for (uint32_t k = 0; k < nm; k++, proto += total) {
+        int16_t c = coef[k];
+        int x = 0;
+#if (defined WITH_NEON && defined __ARM_NEON)
+        /* NEON指令集加速，每次处理8个像素 */
+        int16x8_t vzp = vdupq_n_s16(zp);
+        for (; x + 8 <= n; x += 8) {
+            int16x8_t v = vsubq_s16(vmovl_s8(vld1_s8(proto + x)), vzp);  // 去零点
+            int32x4_t lo = vld1q_s32(acc + x);
+            int32x4_t hi = vld1q_s32(acc + x + 4);
+            lo = vmlal_n_s16(lo, vget_low_s16(v), c);  // 乘累加
+            hi = vmlal_n_s16(hi, vget_high_s16(v), c);
+            vst1q_s32(acc + x, lo);
+            vst1q_s32(acc + x + 4, hi);
+        }
+#endif
+        for (; x < n; x++) {
+            acc[x] += c * (proto[x] - zp);
+        }
+    }
+}
+
+/* 半精度原型扩展为单精度后乘累加，只需ARMv8基础NEON，不依赖半精度运算扩展 */
+/* coef已乘以原型的量化比例，bias为零点对应的常数项 */
+static void MaskRowHalf(const Half* proto, uint32_t total, const float* coef, uint32_t nm, float bias, float* acc, int n)
+{
+    std::fill(acc, acc + n, bias);
+    for (uint32_t k = 0; k < nm; k++, proto += total) {
+        float c = coef[k];
+        int x = 0;
+#if (defined WITH_NEON && defined __aarch64__)
+        /* NEON指令集加速，每次处理8个像素 */
+        for (; x + 8 <= n; x += 8) {
+            float16x8_t v = vld1q_f16(proto + x);
+            float32x4_t lo = vld1q_f32(acc + x);
+            float32x4_t hi = vld1q_f32(acc + x + 4);
+            lo = vfmaq_n_f32(lo, vcvt_f32_f16(vget_low_f16(v)), c);  // 扩展后乘累加
+            hi = vfmaq_n_f32(hi, vcvt_high_f32_f16(v), c);
+            vst1q_f32(acc + x, lo);
+            vst1q_f32(acc + x + 4, hi);
+        }
+#endif
+        for (; x < n; x++) {
+            acc[x] += c * static_cast<float>(proto[x]);
+        }
+    }
+}
+
+template<typename T>
+static void MaskRow(const T* proto, uint32_t total, const float* coef, uint32_t nm, Rknn::Quantization quant, float* acc, int n)
+{
+    std::fill(acc, acc + n, 0.f);
+    for (uint32_t k = 0; k < nm; k++, proto += total) {
+        float c = coef[k];
+        for (int x = 0; x < n; x++) {
+            acc[x] += c * quant.Dequantize(proto[x]);
+        }
+    }
+}
+
+
+YoloSegment::YoloSegment(const std::string &modelPath, float scoreThres, float nmsThres, float maskThres, MemoryMode mode, MemoryGroup* group) :
+YoloDetect(modelPath, scoreThres, nmsThres, mode, group), _maskThres(maskThres)
+{
+
+}
+
+YoloSegment::ResultPtr YoloSegment::Predict(const void* data, size_t len)
+{
+    return Run(data, len, [&]() {
+        return Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum);
+    });
+}
+
+YoloSegment::ResultPtr YoloSegment::Postprocess(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    size_t num
+)
+{
+    /* 输出包含13个张量，前12个为3组，每组包含box、score、score_sum、掩码系数，最后1个为原型张量 */
+    /* (1, 64, 80, 80) (1, 80, 80, 80) (1, 1, 80, 80) (1, 32, 80, 80) ... (1, 32, 160, 160) */
+    /* 不含score_sum的模型每组3个张量 */
+
+    uint32_t size = attr[2].dims[1] == 1 ? 4 : 3;  // 每组张量数
+    uint32_t bunch = (num - 1) / size;  // 组数
+    Candidates candidates;
+    _Decode(output, attr, nativeAttr, bunch, size, candidates);
+
+    /* NMS */
+    auto nmsResult = Utils::NMS(candidates.boxes, candidates.scores, candidates.classes, _head.GetParams().nmsThres);
+
+    /* 仅对NMS保留下来的检测框组装掩码 */
+    ResultPtr result = std::make_unique<Result>();
+    result->reserve(nmsResult.size());
+    auto type = attr[num - 1].type;
+    if (type == RKNN_TENSOR_INT8) {
+        _AssembleMasks<int8_t>(output, attr, nativeAttr, num, size, candidates, nmsResult, *result);
+    } else if (type == RKNN_TENSOR_UINT8) {
+        _AssembleMasks<uint8_t>(output, attr, nativeAttr, num, size, candidates, nmsResult, *result);
+    } else if (type == RKNN_TENSOR_FLOAT32) {
+        _AssembleMasks<float>(output, attr, nativeAttr, num, size, candidates, nmsResult, *result);
+    } else if (type == RKNN_TENSOR_FLOAT16) {
+        _AssembleMasks<Half>(output, attr, nativeAttr, num, size, candidates, nmsResult, *result);
+    }
+
+    return result;
+}
+
+template<typename T>
+void YoloSegment::_AssembleMasks(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    size_t num,
+    uint32_t size,
+    const Candidates &candidates,
+    const std::vector<int> &keep,
+    Result &result)
+{
+    const rknn_tensor_attr &protoAttr = attr[num - 1];
+    uint32_t nm = protoAttr.dims[1];  /* 原型数 */
+    int protoH = protoAttr.dims[2];
+    int protoW = protoAttr.dims[3];
+    uint32_t protoTotal = protoH * protoW;
+    Size inputSize = GetInputSize();
+    float factor = inputSize.width / 1.f / protoW;  // 原型到输入图像的缩放比例
+    const T* proto = static_cast<const T*>(output[num - 1]->virt_addr);  /* (1, nm, ph, pw) */
+    Rknn::Quantization protoQuant {protoAttr.scale, protoAttr.zp};  /* 原型量化参数 */
+
+    /* sigmoid(v) > t 等价于 v > log(t / (1 - t))，阈值换算到logit域后无需计算sigmoid */
+    float logitThres = std::log(_maskThres / (1.f - _maskThres));
+
+    if (keep.empty()) {
+        return;
+    }
+
+    /* NC1HWC2转NCHW */
+    SyncOutput(output[num - 1]);
+    if (nativeAttr[num - 1].fmt == RKNN_TENSOR_NC1HWC2) {
+        T *convertedProto = new T[output[num - 1]->size];
+        Utils::NC1HWC2ToNCHW(proto, convertedProto, &nativeAttr[num - 1], &protoAttr);
+        proto = convertedProto;
+    }
+
+    std::vector<T> coef(nm);  // 掩码系数
+    std::vector<int16_t> coefInt(nm);  // 去零点后的int8掩码系数
+    std::vector<float> coefFloat(nm);  // 反量化后的掩码系数
+    std::vector<int32_t> accInt(protoW);  // 一行int8累加结果
+    std::vector<float> accFloat(protoW);  // 一行浮点累加结果
+    std::vector<uint8_t> lowMask;  // 原型分辨率掩码
+
+    for (auto &idx : keep) {
+        uint32_t coefIndex = candidates.branches[idx] * size + size - 1;  /* 该组掩码系数张量下标 */
+        SyncOutput(output[coefIndex]);
+        const T* coefTensor = static_cast<const T*>(output[coefIndex]->virt_addr);
+        Rknn::Quantization coefQuant {attr[coefIndex].scale, attr[coefIndex].zp};
+        Utils::GatherChannels(coefTensor, coef.data(), candidates.cells[idx], &nativeAttr[coefIndex], &attr[coefIndex]);
+
+        /* 检测框裁剪到输入图像范围内 */
+        const Rect2f &box = candidates.boxes[idx];
+        int x0 = std::clamp(static_cast<int>(std::floor(box.x)), 0, inputSize.width);
+        int y0 = std::clamp(static_cast<int>(std::floor(box.y)), 0, inputSize.height);
+        int x1 = std::clamp(static_cast<int>(std::ceil(box.x + box.width)), 0, inputSize.width);
+        int y1 = std::clamp(static_cast<int>(std::ceil(box.y + box.height)), 0, inputSize.height);
+        Mask mask({x0, y0, x1 - x0, y1 - y0});
+        Detection det(candidates.classes[idx], candidates.scores[idx], box);
+        if (mask.box.width <= 0 || mask.box.height <= 0) {
+            result.emplace_back(det, std::move(mask));
+            continue;
+        }
+
+        /* 检测框对应的原型区域 */
+        int px0 = std::clamp(static_cast<int>(x0 / factor), 0, protoW - 1);
+        int py0 = std::clamp(static_cast<int>(y0 / factor), 0, protoH - 1);
+        int px1 = std::clamp(static_cast<int>(std::ceil(x1 / factor)), px0 + 1, protoW);
+        int py1 = std::clamp(static_cast<int>(std::ceil(y1 / factor)), py0 + 1, protoH);
+        int pw = px1 - px0;
+        int ph = py1 - py0;
+
+        /* 在原型分辨率下计算掩码 */
+        lowMask.assign(pw * ph, 0);
+        if constexpr (std::is_same_v<T, int8_t>) {
+            float accThres = logitThres / (coefQuant.scale * protoQuant.scale);  // 累加域阈值
+            for (uint32_t k = 0; k < nm; k++) {
+                coefInt[k] = static_cast<int16_t>(coef[k] - coefQuant.zp);
+            }
+            for (int y = 0; y < ph; y++) {
+                MaskRowInt8(proto + (py0 + y) * protoW + px0, protoTotal, coefInt.data(), nm,
+                            static_cast<int16_t>(protoQuant.zp), accInt.data(), pw);
+                for (int x = 0; x < pw; x++) {
+                    lowMask[y * pw + x] = accInt[x] > accThres;
+                }
+            }
+        } else if constexpr (std::is_same_v<T, Half>) {
+            float bias = 0.f;
+            for (uint32_t k = 0; k < nm; k++) {
+                coefFloat[k] = coefQuant.Dequantize(coef[k]) * protoQuant.scale;
+                bias -= coefFloat[k] * protoQuant.zp;
+            }
+            for (int y = 0; y < ph; y++) {
+                MaskRowHalf(proto + (py0 + y) * protoW + px0, protoTotal, coefFloat.data(), nm,
+                            bias, accFloat.data(), pw);
+                for (int x = 0; x < pw; x++) {
+                    lowMask[y * pw + x] = accFloat[x] > logitThres;
+                }
+            }
+        } else {
+            for (uint32_t k = 0; k < nm; k++) {
+                coefFloat[k] = coefQuant.Dequantize(coef[k]);
+            }
+            for (int y = 0; y < ph; y++) {
+                MaskRow(proto + (py0 + y) * protoW + px0, protoTotal, coefFloat.data(), nm,
+                        protoQuant, accFloat.data(), pw);
+                for (int x = 0; x < pw; x++) {
+                    lowMask[y * pw + x] = accFloat[x] > logitThres;
+                }
+            }
+        }
+
+        /* 最近邻上采样到输入分辨率并按位压缩，对应同一原型行的输出行直接复制 */
+        int lastRow = -1;
+        for (int y = 0; y < mask.box.height; y++) {
+            int row = std::min(static_cast<int>((y0 + y) / factor) - py0, ph - 1);
+            uint8_t *dst = &mask.bits[y * mask.stride];
+            if (row == lastRow) {
+                std::copy(dst - mask.stride, dst, dst);
+                continue;
+            }
+            for (int x = 0; x < mask.box.width; x++) {
+                int col = std::min(static_cast<int>((x0 + x) / factor) - px0, pw - 1);
+                if (lowMask[row * pw + col]) {
+                    dst[x / 8] |= 1 << (x % 8);
+                }
+            }
+            lastRow = row;
+        }
+
+        result.emplace_back(det, std::move(mask));
+    }
+
+    /* 释放资源 */
+    if (nativeAttr[num - 1].fmt == RKNN_TENSOR_NC1HWC2) {
+        delete[] proto;
+        proto = nullptr;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "types.hpp"
+#include "yolo_detect.hpp"
+
+
+/* 位压缩掩码，box为掩码在模型输入图像中的区域，每行按字节对齐 */
+struct Mask
+{
+    Rect box;
+    uint32_t stride {0};  // 每行字节数
+    std::vector<uint8_t> bits;
+
+    Mask() = default;
+    Mask(const Rect& box) :
+    box(box), stride((box.width + 7) / 8), bits(stride * box.height, 0) {}
+
+    /* (x, y)为相对box左上角的坐标 */
+    inline bool At(int x, int y) const
+    {
+        return (bits[y * stride + x / 8] >> (x % 8)) & 1;
+    }
+};
+
+
+struct Segment : public Detection
+{
+    Mask mask;
+
+    Segment() = default;
+    Segment(const Detection& det, Mask&& mask) :
+    Detection(det), mask(std::move(mask)) {}
+};
+
+
+class YoloSegment : public YoloDetect
+{
+public:
+    using Result = std::vector<Segment>;
+    using ResultPtr = std::unique_ptr<Result>;
+
+    explicit YoloSegment(const std::string &modelPath, float scoreThres = 0.25f, float nmsThres = 0.7f, float maskThres = 0.5f, MemoryMode mode = MemoryMode::Default, MemoryGroup* group = nullptr);
+
+    ResultPtr Predict(const void* data, size_t len);
+
+    ResultPtr Postprocess(
+        const rknn_tensor_mem* const* output,
+        const rknn_tensor_attr* attr,
+        const rknn_tensor_attr* nativeAttr,
+        size_t num
+    );
+
+private:
+    float _maskThres;
+
+    template<typename T>
+    void _AssembleMasks(const rknn_tensor_mem* const* output,
+                        const rknn_tensor_attr* attr,
+                        const rknn_tensor_attr* nativeAttr,
+                        size_t num,
+                        uint32_t size,
+                        const Candidates &candidates,
+                        const std::vector<int> &keep,
+                        Result &result);
+};
@@ -0,0 +1,217 @@
+#include <cmath>
+#include <limits>
+
+#include "yolo_v5_detect.hpp"
+#include "ops.hpp"
+
+
+const Vec2f YoloV5Detect::defaultAnchors = {
+    {10.f, 13.f, 16.f, 30.f, 33.f, 23.f},
+    {30.f, 61.f, 62.f, 45.f, 59.f, 119.f},
+    {116.f, 90.f, 156.f, 198.f, 373.f, 326.f}
+};
+
+
+YoloV5Detect::YoloV5Detect(const std::string &modelPath, float scoreThres, float nmsThres, const Vec2f &anchors, MemoryMode mode, MemoryGroup* group) :
+Engine(modelPath, mode, group), _scoreThres(scoreThres), _nmsThres(nmsThres), _anchors(anchors)
+{
+
+}
+
+YoloV5Detect::ResultPtr YoloV5Detect::Predict(const void* data, size_t len)
+{
+    return Run(data, len, [&]() {
+        return Postprocess(_outputMem, _outputAttr, _outputNativeAttr, _outputNum);
+    });
+}
+
+YoloV5Detect::ResultPtr YoloV5Detect::Postprocess(
+    const rknn_tensor_mem* const* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    size_t num
+)
+{
+    /* 输出包含3个张量，每个张量包含3个anchor，每个anchor依次为x、y、w、h、objectness及各类别得分 */
+    /* (1, 255, 80, 80) (1, 255, 40, 40) (1, 255, 20, 20) */
+
+    std::vector<Rect2f> boxes;  // 检测框
+    std::vector<float> scores;  // 得分
+    std::vector<int> classes;  // 类别
+    auto type = attr[0].type;  // 数据类型
+
+    _decodeStats = DecodeStats();
+    if (_sigmoid.size() < num) {
+        _sigmoid.resize(num);
+    }
+
+    /* 遍历所有尺度输出 */
+    for (uint32_t i = 0; i < num && i < _anchors.size(); i++) {
+        if (type == RKNN_TENSOR_INT8) {
+            _DecodeBunch<int8_t>(output[i], &attr[i], &nativeAttr[i], _anchors[i], &_GetSigmoid<int8_t>(i, &attr[i]), boxes, scores, classes);
+        } else if (type == RKNN_TENSOR_UINT8) {
+            _DecodeBunch<uint8_t>(output[i], &attr[i], &nativeAttr[i], _anchors[i], &_GetSigmoid<uint8_t>(i, &attr[i]), boxes, scores, classes);
+        } else if (type == RKNN_TENSOR_FLOAT32) {
+            _DecodeBunch<float>(output[i], &attr[i], &nativeAttr[i], _anchors[i], nullptr, boxes, scores, classes);
+        }
+    }
+
+    /* NMS */
+    auto nmsResult = Utils::NMS(boxes, scores, classes, _nmsThres);
+
+    /* 输出结果 */
+    ResultPtr result = std::make_unique<Result>();
+    for (auto &i : nmsResult) {
+        result->emplace_back(
+            Detection(
+                classes[i],
+                scores[i],
+                boxes[i]
+            )
+        );
+    }
+
+    return result;
+}
+
+const YoloV5Detect::DecodeStats& YoloV5Detect::GetDecodeStats() const
+{
+    return _decodeStats;
+}
+
+template<typename T>
+const YoloV5Detect::SigmoidCache& YoloV5Detect::_GetSigmoid(uint32_t index, const rknn_tensor_attr* attr)
+{
+    /* 量化参数及分数阈值不变时复用，只在首帧或模型、阈值变化后重建 */
+    SigmoidCache &cache = _sigmoid[index];
+    if (cache.valid && cache.type == attr->type && cache.scale == attr->scale &&
+        cache.zp == attr->zp && cache.thres == _scoreThres) {
+        return cache;
+    }
+
+    cache.valid = true;
+    cache.type = attr->type;
+    cache.scale = attr->scale;
+    cache.zp = attr->zp;
+    cache.thres = _scoreThres;
+    Utils::SigmoidTable<T>(attr->scale, attr->zp, cache.table);
+    cache.objThreshold = std::numeric_limits<T>::max();
+    cache.objReachable = false;
+    for (int q = std::numeric_limits<T>::min(); q <= std::numeric_limits<T>::max(); q++) {
+        if (cache.table[static_cast<uint8_t>(q)] > _scoreThres) {
+            cache.objThreshold = q;
+            cache.objReachable = true;
+            break;
+        }
+    }
+    return cache;
+}
+
+template<typename T>
+void YoloV5Detect::_DecodeBunch(
+    const rknn_tensor_mem* output,
+    const rknn_tensor_attr* attr,
+    const rknn_tensor_attr* nativeAttr,
+    const std::vector<float> &anchors,
+    const SigmoidCache* cache,
+    std::vector<Rect2f> &boxes,
+    std::vector<float> &scores,
+    std::vector<int> &classes)
+{
+    uint32_t gridH = attr->dims[2];
+    uint32_t gridW = attr->dims[3];
+    uint32_t total = gridH * gridW;  /* 网格总数 */
+    uint32_t na = anchors.size() / 2;  /* anchor数 */
+    uint32_t prop = attr->dims[1] / na;  /* 每个anchor的通道数，5 + 类别数 */
+    uint32_t cls = prop - 5;  /* 类别数 */
+    float stride = GetInputSize().width / 1.f / gridW;  // 缩放比例
+    SyncOutput(output);
+    const T* tensor = static_cast<const T*>(output->virt_addr);  /* (1, na*prop, h, w) */
+    Rknn::Quantization quant {attr->scale, attr->zp};  /* 量化参数 */
+
+    /* 8位张量用缓存的查找表计算sigmoid，objectness阈值换算为量化值，类别计算前直接在量化域过滤 */
+    T objThreshold = std::numeric_limits<T>::max();
+    bool objReachable = true;
+    if constexpr (sizeof(T) == 1) {
+        objThreshold = static_cast<T>(cache->objThreshold);
+        objReachable = cache->objReachable;
+    }
+    auto sigmoid = [&](T val) -> float {
+        if constexpr (sizeof(T) == 1) {
+            return cache->table[static_cast<uint8_t>(val)];
+        } else {
+            return 1.f / (1.f + std::exp(-quant.Dequantize(val)));
+        }
+    };
+
+    _decodeStats.cells += total * na;
+    if (!objReachable) {
+        _decodeStats.skipped += total * na;
+        return;
+    }
+
+    /* NC1HWC2转NCHW */
+    if (nativeAttr->fmt == RKNN_TENSOR_NC1HWC2) {
+        T *convertedTensor = new T[output->size];
+        Utils::NC1HWC2ToNCHW(tensor, convertedTensor, nativeAttr, attr);
+        tensor = convertedTensor;
+    }
+
+    /* 遍历所有anchor */
+    for (uint32_t a = 0; a < na; a++) {
+        const T* base = tensor + a * prop * total;  /* 该anchor的首个通道 */
+        for (uint32_t i = 0; i < gridH; i++) {
+            for (uint32_t j = 0; j < gridW; j++) {
+                uint32_t off = i * gridW + j;
+
+                /* objectness过滤 */
+                T obj = base[4 * total + off];
+                if constexpr (sizeof(T) == 1) {
+                    if (obj < objThreshold) {
+                        _decodeStats.skipped++;
+                        continue;
+                    }
+                } else {
+                    if (sigmoid(obj) <= _scoreThres) {
+                        _decodeStats.skipped++;
+                        continue;
+                    }
+                }
+
+                /* 寻找最高得分类别，sigmoid单调，直接比较原始值 */
+                uint32_t maxIndex = 0;
+                T maxScore = base[5 * total + off];
+                for (uint32_t k = 1, coff = 6 * total + off; k < cls; k++, coff += total) {
+                    if (base[coff] > maxScore) {
+                        maxIndex = k;
+                        maxScore = base[coff];
+                    }
+                }
+
+                /* 过滤低分框 */
+                float score = sigmoid(obj) * sigmoid(maxScore);
+                if (score <= _scoreThres) {
+                    continue;
+                }
+
+                /* 计算box坐标 */
+                float cx = (sigmoid(base[off]) * 2.f - 0.5f + j) * stride;
+                float cy = (sigmoid(base[total + off]) * 2.f - 0.5f + i) * stride;
+                float w = sigmoid(base[2 * total + off]) * 2.f;
+                float h = sigmoid(base[3 * total + off]) * 2.f;
+                w = w * w * anchors[2 * a];
+                h = h * h * anchors[2 * a + 1];
+
+                boxes.emplace_back(cx - w / 2.f, cy - h / 2.f, w, h);
+                scores.push_back(score);
+                classes.push_back(maxIndex);
+            }
+        }
+    }
+
+    /* 释放资源 */
+    if (nativeAttr->fmt == RKNN_TENSOR_NC1HWC2) {
+        delete[] tensor;
+        tensor = nullptr;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <array>
+
+#include "types.hpp"
+#include "engine.hpp"
+#include "yolo_detect.hpp"
+
+
+/* 基于anchor的YOLOv5/YOLOv7检测，输出为3组(1, 3*(5+C), H, W) */
+class YoloV5Detect : public Engine
+{
+public:
+    using Result = std::vector<Detection>;
+    using ResultPtr = std::unique_ptr<Result>;
+    using DecodeStats = YoloDetect::DecodeStats;
+
+    /* 每组anchor依次为w0, h0, w1, h1, w2, h2，单位为输入图像像素 */
+    static const Vec2f defaultAnchors;
+
+    explicit YoloV5Detect(const std::string &modelPath,
+                          float scoreThres = 0.25f,
+                          float nmsThres = 0.45f,
+                          const Vec2f &anchors = defaultAnchors,
+                          MemoryMode mode = MemoryMode::Default,
+                          MemoryGroup* group = nullptr);
+
+    ResultPtr Predict(const void* data, size_t len);
+
+    ResultPtr Postprocess(
+        const rknn_tensor_mem* const* output,
+        const rknn_tensor_attr* attr,
+        const rknn_tensor_attr* nativeAttr,
+        size_t num
+    );
+
+    const DecodeStats& GetDecodeStats() const;
+
+private:
+    /* 8位输出张量的sigmoid查找表及量化后的objectness阈值，按量化参数及分数阈值缓存 */
+    struct SigmoidCache
+    {
+        bool valid {false};
+        rknn_tensor_type type {RKNN_TENSOR_INT8};
+        float scale {0.f};
+        int32_t zp {0};
+        float thres {0.f};
+        std::array<float, 256> table;
+        int objThreshold {0};  // 首个sigmoid超过分数阈值的量化值
+        bool objReachable {false};
+    };
+
+    float _scoreThres;
+    float _nmsThres;
+    Vec2f _anchors;
+    DecodeStats _decodeStats;
+    std::vector<SigmoidCache> _sigmoid;  // 与输出张量一一对应
+
+    template<typename T>
+    const SigmoidCache& _GetSigmoid(uint32_t index, const rknn_tensor_attr* attr);
+
+    template<typename T>
+    void _DecodeBunch(const rknn_tensor_mem* output,
+                      const rknn_tensor_attr* attr,
+                      const rknn_tensor_attr* nativeAttr,
+                      const std::vector<float> &anchors,
+                      const SigmoidCache* cache,
+                      std::vector<Rect2f> &boxes,
+                      std::vector<float> &scores,
+                      std::vector<int> &classes);
+};
@@ -4,6 +4,14 @@
 #include <memory>
 #include <vector>
 
+/* 半精度浮点，ARM平台使用原生float16_t，其他平台使用编译器扩展类型 */
+#if (defined __aarch64__ || defined __ARM_FP16_FORMAT_IEEE)
+    #include <arm_fp16.h>
+    using Half = float16_t;
+#else
+    using Half = _Float16;
+#endif
+
 
 struct Size
 {
@@ -39,6 +47,20 @@ using Rect2f = Rect_<float>;
 using Rect2d = Rect_<double>;
 using Rect = Rect2i;
 
+/* 旋转矩形，中心点、宽高及绕中心逆时针的旋转角(弧度) */
+struct RotatedRect
+{
+    float cx {0.f};
+    float cy {0.f};
+    float width {0.f};
+    float height {0.f};
+    float angle {0.f};
+
+    RotatedRect() = default;
+    RotatedRect(float cx, float cy, float width, float height, float angle) :
+    cx(cx), cy(cy), width(width), height(height), angle(angle) {}
+};
+
 using Vec2f = std::vector<std::vector<float>>;
 using Vec2i = std::vector<std::vector<int>>;
 
@@ -78,6 +100,21 @@ struct Transformation
         };
     }
 
+    void ToOriginal(RotatedRect& rect) const
+    {
+        rect.cx = (rect.cx - xOff) / scale;
+        rect.cy = (rect.cy - yOff) / scale;
+        rect.width /= scale;
+        rect.height /= scale;
+    }
+
+    template<typename T>
+    void ToOriginal(T& x, T& y) const
+    {
+        x = static_cast<T>((x - xOff) / scale);
+        y = static_cast<T>((y - yOff) / scale);
+    }
+
     template<typename T>
     void ToTarget(Rect_<T>& rect)
     {
@@ -0,0 +1,192 @@
+#include "cpu_topology.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+
+static const char* RoleName(CpuTopology::Role role)
+{
+    switch (role)
+    {
+        case CpuTopology::Critical:
+            return "critical";
+        case CpuTopology::Background:
+            return "background";
+        default:
+            return "any";
+    }
+}
+
+
+CpuTopology::CpuTopology(const std::string& root)
+{
+    /* 枚举cpuN目录 */
+    std::error_code ec;
+    for (auto& entry : std::filesystem::directory_iterator(root, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() <= 3 || name.compare(0, 3, "cpu") != 0 ||
+            !std::all_of(name.begin() + 3, name.end(), ::isdigit)) {
+            continue;
+        }
+
+        /* 离线的核不参与放置，cpu0通常没有online文件 */
+        std::string dir = entry.path().string();
+        if (_ReadInt(dir + "/online", 1) == 0) {
+            continue;
+        }
+
+        Core core;
+        core.id = std::atoi(name.c_str() + 3);
+        core.maxFreq = _ReadInt(dir + "/cpufreq/cpuinfo_max_freq", 0);
+        core.capacity = static_cast<int>(_ReadInt(dir + "/cpu_capacity", core.maxFreq));
+        _cores.push_back(core);
+    }
+    std::sort(_cores.begin(), _cores.end(), [](const Core& a, const Core& b) { return a.id < b.id; });
+
+    /* 容量最高的一簇为大核，所有核相同时全部视为大核 */
+    int maxCapacity = 0;
+    for (auto& core : _cores) {
+        maxCapacity = std::max(maxCapacity, core.capacity);
+    }
+    for (auto& core : _cores) {
+        core.big = core.capacity == maxCapacity;
+    }
+
+    if (_cores.empty()) {
+        std::printf("no cpu found under %s\r\n", root.c_str());
+    }
+}
+
+const std::vector<CpuTopology::Core>& CpuTopology::GetCores() const
+{
+    return _cores;
+}
+
+std::vector<int> CpuTopology::GetCores(Role role) const
+{
+    std::vector<int> ids;
+    for (auto& core : _cores) {
+        if (role == Any || (role == Critical) == core.big) {
+            ids.push_back(core.id);
+        }
+    }
+
+    /* 没有小核时后台线程与其他线程共享全部核 */
+    if (ids.empty()) {
+        for (auto& core : _cores) {
+            ids.push_back(core.id);
+        }
+    }
+    return ids;
+}
+
+bool CpuTopology::Place(const std::string& name, Role role, int fifoPriority)
+{
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    bool ok = true;
+
+    /* 绑定到对应簇 */
+    auto ids = GetCores(role);
+    if (!ids.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto& id : ids) {
+            CPU_SET(id, &set);
+        }
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            std::printf("set affinity of %s failed\r\n", name.c_str());
+            ok = false;
+        }
+    }
+
+    /* 可选实时优先级，需要CAP_SYS_NICE */
+    if (fifoPriority > 0) {
+        sched_param param {};
+        param.sched_priority = fifoPriority;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+            std::printf("set SCHED_FIFO %d of %s failed\r\n", fifoPriority, name.c_str());
+            ok = false;
+        }
+    }
+
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _threads.push_back({name, tid, role});
+    return ok;
+}
+
+std::vector<CpuTopology::ThreadInfo> CpuTopology::GetThreads() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<ThreadInfo> infos;
+    for (auto& t : _threads) {
+        ThreadInfo info {t.name, t.tid, t.role};
+        _ReadSched(t.tid, info.migrations, info.switches);
+        infos.push_back(info);
+    }
+    return infos;
+}
+
+void CpuTopology::Dump() const
+{
+    std::printf("cpu:");
+    for (auto& core : _cores) {
+        std::printf(" %d(%s, %d, %ld kHz)", core.id, core.big ? "big" : "little", core.capacity, core.maxFreq);
+    }
+    std::printf("\r\n");
+
+    for (auto& info : GetThreads()) {
+        if (info.migrations < 0) {
+            std::printf("thread %s (%d, %s): exited\r\n", info.name.c_str(), info.tid, RoleName(info.role));
+        } else {
+            std::printf("thread %s (%d, %s): migrations %ld, switches %ld\r\n",
+                        info.name.c_str(),
+                        info.tid,
+                        RoleName(info.role),
+                        info.migrations,
+                        info.switches);
+        }
+    }
+}
+
+int64_t CpuTopology::_ReadInt(const std::string& path, int64_t def)
+{
+    std::ifstream ifs(path);
+    int64_t value = def;
+    if (!(ifs >> value)) {
+        return def;
+    }
+    return value;
+}
+
+bool CpuTopology::_ReadSched(pid_t tid, int64_t& migrations, int64_t& switches)
+{
+    /* 格式为 "se.nr_migrations   :   12" */
+    std::ifstream ifs("/proc/self/task/" + std::to_string(tid) + "/sched");
+    if (!ifs.good()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(ifs, line)) {
+        auto pos = line.find(':');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        int64_t value = std::atoll(line.c_str() + pos + 1);
+        if (line.compare(0, 16, "se.nr_migrations") == 0) {
+            migrations = value;
+        } else if (line.compare(0, 11, "nr_switches") == 0) {
+            switches = value;
+        }
+    }
+    return migrations >= 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <sys/types.h>
+
+
+/* 大小核拓扑及线程放置，延迟敏感的线程绑定大核，后台线程绑定小核 */
+/* 拓扑从sysfs读取，root可指向伪造的目录以便在无目标板的环境验证 */
+class CpuTopology
+{
+public:
+    enum Role
+    {
+        Critical,  // 后处理、NMS、流水线驱动
+        Background,  // 解码预取、预览呈现
+        Any,
+    };
+
+    struct Core
+    {
+        int id {0};
+        int capacity {0};  // cpu_capacity，缺失时以最高频率代替
+        int64_t maxFreq {0};  // kHz
+        bool big {false};
+    };
+
+    struct ThreadInfo
+    {
+        std::string name;
+        pid_t tid {0};
+        Role role {Any};
+        int64_t migrations {-1};  // 线程已退出时为-1
+        int64_t switches {-1};  // 上下文切换次数
+    };
+
+    explicit CpuTopology(const std::string& root = "/sys/devices/system/cpu");
+
+    const std::vector<Core>& GetCores() const;
+    std::vector<int> GetCores(Role role) const;
+
+    bool Place(const std::string& name, Role role, int fifoPriority = 0);
+    std::vector<ThreadInfo> GetThreads() const;
+    void Dump() const;
+
+private:
+    struct Entry
+    {
+        std::string name;
+        pid_t tid;
+        Role role;
+    };
+
+    std::vector<Core> _cores;
+    std::vector<Entry> _threads;
+    mutable std::mutex _mutex;
+
+    static int64_t _ReadInt(const std::string& path, int64_t def);
+    static bool _ReadSched(pid_t tid, int64_t& migrations, int64_t& switches);
+};
@@ -0,0 +1,130 @@
+#include "detection_eval.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "ops.hpp"
+
+
+void DetectionEvaluator::Add(const std::vector<Object>& truths, const std::vector<Object>& detections)
+{
+    _images.push_back({truths, detections});
+    for (auto& obj : truths) {
+        _classNum = std::max(_classNum, obj.id + 1);
+    }
+    for (auto& obj : detections) {
+        _classNum = std::max(_classNum, obj.id + 1);
+    }
+}
+
+void DetectionEvaluator::Reset()
+{
+    _images.clear();
+    _classNum = 0;
+}
+
+size_t DetectionEvaluator::GetImageNum() const
+{
+    return _images.size();
+}
+
+double DetectionEvaluator::MeanAP(float iou) const
+{
+    /* 没有标注的类别不参与平均 */
+    double sum = 0.;
+    int num = 0;
+    for (int c = 0; c < _classNum; c++) {
+        double ap = _AveragePrecision(c, iou);
+        if (ap >= 0.) {
+            sum += ap;
+            num++;
+        }
+    }
+    return num > 0 ? sum / num : 0.;
+}
+
+double DetectionEvaluator::MeanAP() const
+{
+    double sum = 0.;
+    for (int i = 0; i < 10; i++) {
+        sum += MeanAP(0.5f + 0.05f * i);
+    }
+    return sum / 10.;
+}
+
+double DetectionEvaluator::_AveragePrecision(int cls, float iou) const
+{
+    /* 收集该类别所有检测框，按分数降序 */
+    struct Ref
+    {
+        size_t image;
+        size_t index;
+        float score;
+    };
+    std::vector<Ref> refs;
+    size_t truthNum = 0;
+    for (size_t i = 0; i < _images.size(); i++) {
+        for (size_t j = 0; j < _images[i].detections.size(); j++) {
+            if (_images[i].detections[j].id == cls) {
+                refs.push_back({i, j, _images[i].detections[j].score});
+            }
+        }
+        for (auto& obj : _images[i].truths) {
+            truthNum += obj.id == cls;
+        }
+    }
+    if (truthNum == 0) {
+        return -1.;
+    }
+    std::stable_sort(refs.begin(), refs.end(), [](const Ref& a, const Ref& b) {
+        return a.score > b.score;
+    });
+
+    /* 依次与同图同类未匹配的标注框做最大IoU匹配 */
+    std::vector<std::vector<bool>> matched(_images.size());
+    for (size_t i = 0; i < _images.size(); i++) {
+        matched[i].assign(_images[i].truths.size(), false);
+    }
+    std::vector<float> precision(refs.size());
+    std::vector<float> recall(refs.size());
+    size_t tp = 0;
+    for (size_t k = 0; k < refs.size(); k++) {
+        const Image& img = _images[refs[k].image];
+        const Rect2f& box = img.detections[refs[k].index].box;
+        float best = iou;
+        int match = -1;
+        for (size_t t = 0; t < img.truths.size(); t++) {
+            if (img.truths[t].id != cls || matched[refs[k].image][t]) {
+                continue;
+            }
+            float v = Utils::IoU(box, img.truths[t].box);
+            if (v >= best) {
+                best = v;
+                match = static_cast<int>(t);
+            }
+        }
+        if (match >= 0) {
+            matched[refs[k].image][match] = true;
+            tp++;
+        }
+        precision[k] = tp / static_cast<float>(k + 1);
+        recall[k] = tp / static_cast<float>(truthNum);
+    }
+
+    /* 精度取右侧最大值后在101个召回点上采样 */
+    for (int k = static_cast<int>(precision.size()) - 2; k >= 0; k--) {
+        precision[k] = std::max(precision[k], precision[k + 1]);
+    }
+    double sum = 0.;
+    size_t k = 0;
+    for (int r = 0; r <= 100; r++) {
+        float target = r / 100.f;
+        while (k < recall.size() && recall[k] < target) {
+            k++;
+        }
+        if (k < recall.size()) {
+            sum += precision[k];
+        }
+    }
+    return sum / 101.;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include "types.hpp"
+
+
+/* COCO方式的检测精度评估，按类别计算101点插值AP后取平均 */
+class DetectionEvaluator
+{
+public:
+    struct Object
+    {
+        int id {-1};
+        float score {1.f};  // 标注框不使用
+        Rect2f box;
+    };
+
+    void Add(const std::vector<Object>& truths, const std::vector<Object>& detections);
+    void Reset();
+
+    size_t GetImageNum() const;
+    double MeanAP(float iou) const;  // 指定IoU阈值下的mAP
+    double MeanAP() const;  // IoU阈值0.5:0.05:0.95下的平均mAP
+
+private:
+    struct Image
+    {
+        std::vector<Object> truths;
+        std::vector<Object> detections;
+    };
+
+    std::vector<Image> _images;
+    int _classNum {0};
+
+    double _AveragePrecision(int cls, float iou) const;
+};
@@ -0,0 +1,101 @@
+#include "histogram.hpp"
+
+#include <cstdio>
+#include <algorithm>
+
+
+void Histogram::Add(int64_t value)
+{
+    value = std::max<int64_t>(value, 0);
+    _buckets[_Index(value)]++;
+    _count++;
+    _sum += value;
+    _max = std::max(_max, value);
+}
+
+void Histogram::Merge(const Histogram& other)
+{
+    for (int i = 0; i < _bucketNum; i++) {
+        _buckets[i] += other._buckets[i];
+    }
+    _count += other._count;
+    _sum += other._sum;
+    _max = std::max(_max, other._max);
+}
+
+void Histogram::Reset()
+{
+    _buckets.fill(0);
+    _count = 0;
+    _sum = 0;
+    _max = 0;
+}
+
+uint64_t Histogram::Count() const
+{
+    return _count;
+}
+
+double Histogram::Mean() const
+{
+    return _count > 0 ? _sum / 1. / _count : 0.;
+}
+
+int64_t Histogram::Max() const
+{
+    return _max;
+}
+
+int64_t Histogram::Percentile(double p) const
+{
+    if (_count == 0) {
+        return 0;
+    }
+
+    /* 返回第一个累计数达到目标的桶上界 */
+    uint64_t target = static_cast<uint64_t>(p / 100. * _count + 0.5);
+    target = std::clamp<uint64_t>(target, 1, _count);
+    uint64_t acc = 0;
+    for (int i = 0; i < _bucketNum; i++) {
+        acc += _buckets[i];
+        if (acc >= target) {
+            return std::min(_Upper(i), _max);
+        }
+    }
+    return _max;
+}
+
+void Histogram::Dump(const char* tag, const char* unit) const
+{
+    std::printf("%s: count: %lu, mean: %.1f%s, p50: %ld%s, p90: %ld%s, p99: %ld%s, max: %ld%s\r\n",
+                tag,
+                _count,
+                Mean(), unit,
+                Percentile(50.), unit,
+                Percentile(90.), unit,
+                Percentile(99.), unit,
+                _max, unit);
+}
+
+int Histogram::_Index(int64_t value)
+{
+    /* 小于8的值各占一个桶 */
+    if (value < (1 << _subBits)) {
+        return static_cast<int>(value);
+    }
+
+    int exp = 63 - __builtin_clzll(static_cast<uint64_t>(value));  // 最高位
+    int sub = static_cast<int>((value >> (exp - _subBits)) & ((1 << _subBits) - 1));
+    return ((exp - _subBits + 1) << _subBits) + sub;
+}
+
+int64_t Histogram::_Upper(int index)
+{
+    if (index < (1 << _subBits)) {
+        return index;
+    }
+
+    int exp = (index >> _subBits) + _subBits - 1;
+    int sub = index & ((1 << _subBits) - 1);
+    return ((static_cast<int64_t>((1 << _subBits) + sub + 1)) << (exp - _subBits)) - 1;
+}
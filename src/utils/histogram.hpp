@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+
+/* 对数分桶的延迟直方图，每个2的幂区间再均分为8个子桶，默认单位为微秒 */
+class Histogram
+{
+public:
+    void Add(int64_t value);
+    void Merge(const Histogram& other);
+    void Reset();
+
+    uint64_t Count() const;
+    double Mean() const;
+    int64_t Max() const;
+    int64_t Percentile(double p) const;
+
+    void Dump(const char* tag, const char* unit = " us") const;
+
+private:
+    static constexpr int _subBits = 3;
+    static constexpr int _bucketNum = (64 - _subBits + 1) << _subBits;
+
+    std::array<uint64_t, _bucketNum> _buckets {};
+    uint64_t _count {0};
+    int64_t _sum {0};
+    int64_t _max {0};
+
+    static int _Index(int64_t value);
+    static int64_t _Upper(int index);
+};
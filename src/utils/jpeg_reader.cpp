@@ -0,0 +1,181 @@
+#include "jpeg_reader.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef WITH_TURBOJPEG
+    #include <turbojpeg.h>
+#else
+    #include <opencv2/imgcodecs.hpp>
+#endif
+
+
+JpegReader::JpegReader()
+{
+#ifdef WITH_TURBOJPEG
+    _handle = tjInitDecompress();
+    if (_handle == nullptr) {
+        std::printf("init turbojpeg failed\r\n");
+    }
+#endif
+}
+
+JpegReader::~JpegReader()
+{
+#ifdef WITH_TURBOJPEG
+    if (_handle) {
+        tjDestroy(_handle);
+        _handle = nullptr;
+    }
+#endif
+}
+
+bool JpegReader::Read(const std::string& path, const Size& target)
+{
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    if (!ifs.good()) {
+        std::printf("open image %s failed\r\n", path.c_str());
+        return false;
+    }
+
+    size_t len = ifs.tellg();
+    ifs.seekg(0);
+    _file.resize(len);
+    if (!ifs.read(reinterpret_cast<char*>(_file.data()), len)) {
+        std::printf("read image %s failed\r\n", path.c_str());
+        return false;
+    }
+
+    return Decode(_file.data(), len, target);
+}
+
+bool JpegReader::Decode(const uint8_t* data, size_t len, const Size& target)
+{
+#ifdef WITH_TURBOJPEG
+    if (_handle == nullptr) {
+        return false;
+    }
+
+    int width, height, subsamp, colorspace;
+    if (tjDecompressHeader3(_handle, data, len, &width, &height, &subsamp, &colorspace) != 0) {
+        std::printf("parse jpeg header failed: %s\r\n", tjGetErrorStr2(_handle));
+        return false;
+    }
+    _original = {width, height};
+    _denominator = _Denominator(_original, target);
+
+    /* 在DCT域缩小解码 */
+    tjscalingfactor factor {1, _denominator};
+    _size = {TJSCALED(width, factor), TJSCALED(height, factor)};
+    size_t need = static_cast<size_t>(_size.width) * _size.height * 3;
+    if (_buffer.size() < need) {
+        _buffer.resize(need);
+    }
+    if (tjDecompress2(_handle, data, len, _buffer.data(), _size.width, _size.width * 3, _size.height, TJPF_BGR, TJFLAG_FASTDCT) != 0) {
+        std::printf("decode jpeg failed: %s\r\n", tjGetErrorStr2(_handle));
+        return false;
+    }
+#else
+    if (!_ParseSize(data, len, _original)) {
+        std::printf("parse jpeg header failed\r\n");
+        return false;
+    }
+    _denominator = _Denominator(_original, target);
+
+    /* OpenCV同样在DCT域缩小解码 */
+    int flag = cv::IMREAD_COLOR;
+    if (_denominator == 2) {
+        flag = cv::IMREAD_REDUCED_COLOR_2;
+    } else if (_denominator == 4) {
+        flag = cv::IMREAD_REDUCED_COLOR_4;
+    } else if (_denominator == 8) {
+        flag = cv::IMREAD_REDUCED_COLOR_8;
+    }
+    cv::Mat img = cv::imdecode(cv::Mat(1, len, CV_8UC1, const_cast<uint8_t*>(data)), flag);
+    if (img.empty()) {
+        std::printf("decode jpeg failed\r\n");
+        return false;
+    }
+    _size = {img.cols, img.rows};
+    size_t need = static_cast<size_t>(_size.width) * _size.height * 3;
+    if (_buffer.size() < need) {
+        _buffer.resize(need);
+    }
+    for (int y = 0; y < img.rows; y++) {
+        std::memcpy(_buffer.data() + y * _size.width * 3, img.ptr<uint8_t>(y), _size.width * 3);
+    }
+#endif
+
+    return true;
+}
+
+const uint8_t* JpegReader::Data() const
+{
+    return _buffer.data();
+}
+
+Size JpegReader::GetSize() const
+{
+    return _size;
+}
+
+Size JpegReader::GetOriginalSize() const
+{
+    return _original;
+}
+
+int JpegReader::GetDenominator() const
+{
+    return _denominator;
+}
+
+Transformation JpegReader::GetTransformation(const Size& input) const
+{
+    /* 解码图letterbox到输入的变换，叠加原图到解码图的缩小比例 */
+    Transformation trans(_size, input);
+    trans.scale *= _size.width / 1.f / _original.width;
+    return trans;
+}
+
+int JpegReader::_Denominator(const Size& original, const Size& target)
+{
+    /* 缩小后任一边仍不小于输入尺寸时，letterbox只缩不放 */
+    for (int denominator = 8; denominator > 1; denominator /= 2) {
+        int w = (original.width + denominator - 1) / denominator;
+        int h = (original.height + denominator - 1) / denominator;
+        if (w >= target.width || h >= target.height) {
+            return denominator;
+        }
+    }
+    return 1;
+}
+
+bool JpegReader::_ParseSize(const uint8_t* data, size_t len, Size& size)
+{
+    /* 跳过各段直到SOFn，其中记录了图像宽高 */
+    if (len < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return false;
+    }
+
+    size_t pos = 2;
+    while (pos + 9 < len) {
+        if (data[pos] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) {
+            pos++;
+            continue;
+        }
+        uint16_t segment = (data[pos + 2] << 8) | data[pos + 3];
+        bool sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (sof) {
+            size.height = (data[pos + 5] << 8) | data[pos + 6];
+            size.width = (data[pos + 7] << 8) | data[pos + 8];
+            return size.width > 0 && size.height > 0;
+        }
+        pos += 2 + segment;
+    }
+    return false;
+}
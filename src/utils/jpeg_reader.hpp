@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+
+
+/* JPEG读取，在DCT域按1/2、1/4、1/8缩小，解码尺寸刚好不小于模型输入，输出BGR888 */
+/* 启用WITH_TURBOJPEG时使用libjpeg-turbo，否则退化为OpenCV的缩小解码 */
+class JpegReader
+{
+public:
+    JpegReader();
+    ~JpegReader();
+
+    JpegReader(const JpegReader&) = delete;
+    JpegReader& operator=(const JpegReader&) = delete;
+
+    bool Read(const std::string& path, const Size& target);
+    bool Decode(const uint8_t* data, size_t len, const Size& target);
+
+    const uint8_t* Data() const;
+    Size GetSize() const;  // 解码后尺寸
+    Size GetOriginalSize() const;
+    int GetDenominator() const;  // 缩小倍数
+
+    /* 原图到letterbox后模型输入的变换，ToOriginal可直接将检测框映射回原图 */
+    Transformation GetTransformation(const Size& input) const;
+
+private:
+    void* _handle {nullptr};  // tjhandle
+    std::vector<uint8_t> _file;  // 复用的文件缓冲
+    std::vector<uint8_t> _buffer;  // 复用的解码缓冲
+    Size _size;
+    Size _original;
+    int _denominator {1};
+
+    static int _Denominator(const Size& original, const Size& target);
+    static bool _ParseSize(const uint8_t* data, size_t len, Size& size);
+};
@@ -0,0 +1,17 @@
+#include "letterbox.hpp"
+
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+
+void Letterbox(const cv::Mat& src, const Size& dst, cv::Mat& out)
+{
+    Transformation trans({src.cols, src.rows}, dst);
+    int w = std::max(1, static_cast<int>(src.cols * trans.scale));
+    int h = std::max(1, static_cast<int>(src.rows * trans.scale));
+    out.create(dst.height, dst.width, CV_8UC3);
+    out.setTo(cv::Scalar(0, 0, 0));
+    cv::Mat roi = out(cv::Rect(trans.xOff, trans.yOff, std::min(w, dst.width - trans.xOff), std::min(h, dst.height - trans.yOff)));
+    cv::resize(src, roi, roi.size());
+}
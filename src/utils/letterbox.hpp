@@ -0,0 +1,9 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include "types.hpp"
+
+
+/* 等比缩放并居中填充到dst尺寸，与Transformation(src, dst)的映射一致，out尺寸匹配时复用其内存 */
+void Letterbox(const cv::Mat& src, const Size& dst, cv::Mat& out);
@@ -4,6 +4,10 @@
 #include <algorithm>
 #include <set>
 
+#ifdef WITH_NEON
+    #include "arm_neon.h"
+#endif
+
 
 namespace Utils
 {
@@ -106,4 +110,293 @@ namespace Utils
 
         return result;
     }
+
+    void RotatedCorners(const RotatedRect& box, float* points)
+    {
+        float c = std::cos(box.angle);
+        float s = std::sin(box.angle);
+        float dx = box.width / 2.f;
+        float dy = box.height / 2.f;
+        const float sx[4] = {-dx, dx, dx, -dx};
+        const float sy[4] = {-dy, -dy, dy, dy};
+        for (int k = 0; k < 4; k++) {
+            points[2 * k] = box.cx + sx[k] * c - sy[k] * s;
+            points[2 * k + 1] = box.cy + sx[k] * s + sy[k] * c;
+        }
+    }
+
+    /* 以凸多边形clip的各边依次裁剪subject(Sutherland-Hodgman)，两个四边形的交最多8个顶点 */
+    static int ClipConvex(const float* subject, int n, const float* clip, float* out)
+    {
+        float buffer[2][32];
+        const float* src = subject;
+        int count = n;
+        for (int e = 0; e < 4 && count > 0; e++) {
+            float ax = clip[2 * e];
+            float ay = clip[2 * e + 1];
+            float bx = clip[(2 * e + 2) % 8];
+            float by = clip[(2 * e + 3) % 8];
+            float* dst = e == 3 ? out : buffer[e % 2];
+            int m = 0;
+            for (int k = 0; k < count; k++) {
+                float px = src[2 * k];
+                float py = src[2 * k + 1];
+                float qx = src[(2 * k + 2) % (2 * count)];
+                float qy = src[(2 * k + 3) % (2 * count)];
+                float dp = (bx - ax) * (py - ay) - (by - ay) * (px - ax);  // 逆时针排列时左侧为内
+                float dq = (bx - ax) * (qy - ay) - (by - ay) * (qx - ax);
+                if (dp >= 0.f) {
+                    dst[2 * m] = px;
+                    dst[2 * m + 1] = py;
+                    m++;
+                }
+                if ((dp >= 0.f) != (dq >= 0.f)) {
+                    float t = dp / (dp - dq);
+                    dst[2 * m] = px + t * (qx - px);
+                    dst[2 * m + 1] = py + t * (qy - py);
+                    m++;
+                }
+            }
+            src = dst;
+            count = m;
+        }
+        return count;
+    }
+
+    static float PolygonArea(const float* points, int n)
+    {
+        float area = 0.f;
+        for (int k = 0; k < n; k++) {
+            int l = (k + 1) % n;
+            area += points[2 * k] * points[2 * l + 1] - points[2 * l] * points[2 * k + 1];
+        }
+        return std::fabs(area) / 2.f;
+    }
+
+    /* 已知顶点时求交并比，供NMS复用预先计算的顶点 */
+    static float RotatedIoU(const float* p1, float a1, const float* p2, float a2)
+    {
+        float out[32];
+        int n = ClipConvex(p1, 4, p2, out);
+        if (n < 3) {
+            return 0.f;
+        }
+        float i = PolygonArea(out, n);
+        float u = a1 + a2 - i;
+        return u <= 0.f ? 0.f : (i / u);
+    }
+
+    float RotatedIoU(const RotatedRect& b1, const RotatedRect& b2)
+    {
+        float p1[8], p2[8];
+        RotatedCorners(b1, p1);
+        RotatedCorners(b2, p2);
+        return RotatedIoU(p1, b1.width * b1.height, p2, b2.width * b2.height);
+    }
+
+    std::vector<int> RotatedNMS(
+        const std::vector<RotatedRect>& boxes,
+        const std::vector<float>& scores,
+        const std::vector<int>& classes,
+        float threshold,
+        RotatedNMSStats* stats
+    )
+    {
+        /* 按类别、分数降序排序，同类框连续存放，只在类内比较 */
+        size_t n = boxes.size();
+        std::vector<int> order(n);
+        for (size_t i = 0; i < n; i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](const int& a, const int& b) {
+            return classes[a] != classes[b] ? classes[a] < classes[b] : scores[a] > scores[b];
+        });
+
+        /* 按排序后的顺序以SoA排布顶点、外接矩形及面积 */
+        std::vector<float> points(n * 8);
+        std::vector<float> xmin(n), ymin(n), xmax(n), ymax(n), area(n);
+        for (size_t i = 0; i < n; i++) {
+            const RotatedRect& box = boxes[order[i]];
+            float* p = &points[i * 8];
+            RotatedCorners(box, p);
+            xmin[i] = std::min(std::min(p[0], p[2]), std::min(p[4], p[6]));
+            xmax[i] = std::max(std::max(p[0], p[2]), std::max(p[4], p[6]));
+            ymin[i] = std::min(std::min(p[1], p[3]), std::min(p[5], p[7]));
+            ymax[i] = std::max(std::max(p[1], p[3]), std::max(p[5], p[7]));
+            area[i] = box.width * box.height;
+        }
+
+        std::vector<int> result;
+        std::vector<uint8_t> removed(n, 0);
+        std::vector<uint32_t> hit(n);  // 外接矩形预判可能超过阈值的框
+        RotatedNMSStats local;
+        for (size_t begin = 0, end = 0; begin < n; begin = end) {
+            /* 当前类别的范围 */
+            end = begin;
+            while (end < n && classes[order[end]] == classes[order[begin]]) {
+                end++;
+            }
+
+            for (size_t i = begin; i < end; i++) {
+                if (removed[i]) {
+                    continue;
+                }
+                result.push_back(order[i]);
+                local.pairs += end - i - 1;
+
+                /* IoU随交集面积单调增，交集不超过外接矩形交集及两框中较小的面积，以此上界判定 */
+                /* 上界 I 满足 I > thres * (a1 + a2 - I) 时才需要精确求交 */
+                size_t j = i + 1;
+#if (defined WITH_NEON && defined __ARM_NEON)
+                /* NEON指令集加速，每次预判4个框 */
+                float32x4_t vx0 = vdupq_n_f32(xmin[i]);
+                float32x4_t vy0 = vdupq_n_f32(ymin[i]);
+                float32x4_t vx1 = vdupq_n_f32(xmax[i]);
+                float32x4_t vy1 = vdupq_n_f32(ymax[i]);
+                float32x4_t va = vdupq_n_f32(area[i]);
+                float32x4_t vzero = vdupq_n_f32(0.f);
+                for (; j + 4 <= end; j += 4) {
+                    float32x4_t w = vmaxq_f32(vsubq_f32(vminq_f32(vx1, vld1q_f32(&xmax[j])), vmaxq_f32(vx0, vld1q_f32(&xmin[j]))), vzero);
+                    float32x4_t h = vmaxq_f32(vsubq_f32(vminq_f32(vy1, vld1q_f32(&ymax[j])), vmaxq_f32(vy0, vld1q_f32(&ymin[j]))), vzero);
+                    float32x4_t aj = vld1q_f32(&area[j]);
+                    float32x4_t upper = vminq_f32(vmulq_f32(w, h), vminq_f32(va, aj));
+                    float32x4_t rhs = vmulq_n_f32(vsubq_f32(vaddq_f32(va, aj), upper), threshold);
+                    vst1q_u32(&hit[j], vcgtq_f32(upper, rhs));
+                }
+#endif
+                for (; j < end; j++) {
+                    float w = std::max(std::min(xmax[i], xmax[j]) - std::max(xmin[i], xmin[j]), 0.f);
+                    float h = std::max(std::min(ymax[i], ymax[j]) - std::max(ymin[i], ymin[j]), 0.f);
+                    float upper = std::min(w * h, std::min(area[i], area[j]));
+                    hit[j] = upper > threshold * (area[i] + area[j] - upper) ? 0xffffffff : 0;
+                }
+
+                /* 只对预判通过的框做多边形求交 */
+                for (j = i + 1; j < end; j++) {
+                    if (!hit[j] || removed[j]) {
+                        continue;
+                    }
+                    local.exact++;
+                    if (RotatedIoU(&points[i * 8], area[i], &points[j * 8], area[j]) > threshold) {
+                        removed[j] = 1;
+                    }
+                }
+            }
+        }
+
+        if (stats) {
+            stats->pairs += local.pairs;
+            stats->exact += local.exact;
+        }
+        return result;
+    }
+
+    void ToOriginal(const Transformation& trans, float* x, float* y, float* width, float* height, size_t n)
+    {
+        /* (v - off) / scale 改写为 v * inv + bias，一次乘加完成 */
+        float inv = 1.f / trans.scale;
+        float xBias = -trans.xOff * inv;
+        float yBias = -trans.yOff * inv;
+        size_t i = 0;
+#if (defined WITH_NEON && defined __ARM_NEON)
+        /* NEON指令集加速，每次处理4个框 */
+        float32x4_t vxBias = vdupq_n_f32(xBias);
+        float32x4_t vyBias = vdupq_n_f32(yBias);
+        for (; i + 4 <= n; i += 4) {
+            vst1q_f32(x + i, vmlaq_n_f32(vxBias, vld1q_f32(x + i), inv));
+            vst1q_f32(y + i, vmlaq_n_f32(vyBias, vld1q_f32(y + i), inv));
+            vst1q_f32(width + i, vmulq_n_f32(vld1q_f32(width + i), inv));
+            vst1q_f32(height + i, vmulq_n_f32(vld1q_f32(height + i), inv));
+        }
+#endif
+        for (; i < n; i++) {
+            x[i] = x[i] * inv + xBias;
+            y[i] = y[i] * inv + yBias;
+            width[i] *= inv;
+            height[i] *= inv;
+        }
+    }
+
+    void CropResize(const uint8_t* src, size_t stride, const Rect* rois, size_t n, int8_t* dst, const Size& size, bool swapRB)
+    {
+        /* 11位定点权重，两次插值的乘积不超过int32 */
+        constexpr int bits = 11;
+        constexpr int one = 1 << bits;
+        std::vector<int32_t> x0(size.width);  // 每列左侧源像素字节偏移
+        std::vector<int32_t> x1(size.width);  // 每列右侧源像素字节偏移
+        std::vector<int32_t> wx(size.width);  // 每列右侧权重
+        int r = swapRB ? 2 : 0;
+        int b = swapRB ? 0 : 2;
+
+        for (size_t k = 0; k < n; k++, dst += size.size() * 3) {
+            const Rect& roi = rois[k];
+            float sx = roi.width / 1.f / size.width;
+            float sy = roi.height / 1.f / size.height;
+
+            /* 同一区域内各行共用列坐标及权重 */
+            for (int x = 0; x < size.width; x++) {
+                float fx = std::clamp((x + 0.5f) * sx - 0.5f, 0.f, roi.width - 1.f);
+                int ix = static_cast<int>(fx);
+                x0[x] = (roi.x + ix) * 3;
+                x1[x] = (roi.x + std::min(ix + 1, roi.width - 1)) * 3;
+                wx[x] = static_cast<int32_t>((fx - ix) * one + 0.5f);
+            }
+
+            int8_t* dp = dst;
+            for (int y = 0; y < size.height; y++) {
+                float fy = std::clamp((y + 0.5f) * sy - 0.5f, 0.f, roi.height - 1.f);
+                int iy = static_cast<int>(fy);
+                int32_t wy = static_cast<int32_t>((fy - iy) * one + 0.5f);
+                const uint8_t* row0 = src + (roi.y + iy) * stride;
+                const uint8_t* row1 = src + (roi.y + std::min(iy + 1, roi.height - 1)) * stride;
+                for (int x = 0; x < size.width; x++, dp += 3) {
+                    const uint8_t* p00 = row0 + x0[x];
+                    const uint8_t* p01 = row0 + x1[x];
+                    const uint8_t* p10 = row1 + x0[x];
+                    const uint8_t* p11 = row1 + x1[x];
+                    int32_t w = wx[x];
+                    for (int c = 0; c < 3; c++) {
+                        int32_t top = p00[c] * (one - w) + p01[c] * w;
+                        int32_t bottom = p10[c] * (one - w) + p11[c] * w;
+                        int32_t v = (top * (one - wy) + bottom * wy + (1 << (2 * bits - 1))) >> (2 * bits);
+                        dp[c == 0 ? r : (c == 2 ? b : 1)] = static_cast<int8_t>(v - 128);
+                    }
+                }
+            }
+        }
+    }
+
+    void ArgmaxHalf(const Half* score, uint32_t total, uint32_t cls, uint32_t n, Half* maxScore, uint16_t* maxIndex)
+    {
+        uint32_t j = 0;
+#if (defined WITH_NEON && defined __ARM_FEATURE_FP16_VECTOR_ARITHMETIC)
+        /* NEON半精度指令，每次处理8个网格，逐类别平面比较，严格大于时更新，与标量版本的结果一致 */
+        for (; j + 8 <= n; j += 8) {
+            float16x8_t vmax = vld1q_f16(score + j);
+            uint16x8_t vidx = vdupq_n_u16(0);
+            const Half* plane = score + j + total;
+            for (uint32_t k = 1; k < cls; k++, plane += total) {
+                float16x8_t v = vld1q_f16(plane);
+                uint16x8_t gt = vcgtq_f16(v, vmax);
+                vmax = vbslq_f16(gt, v, vmax);
+                vidx = vbslq_u16(gt, vdupq_n_u16(k), vidx);
+            }
+            vst1q_f16(maxScore + j, vmax);
+            vst1q_u16(maxIndex + j, vidx);
+        }
+#endif
+        for (; j < n; j++) {
+            Half max = score[j];
+            uint16_t index = 0;
+            const Half* plane = score + j + total;
+            for (uint32_t k = 1; k < cls; k++, plane += total) {
+                if (*plane > max) {
+                    max = *plane;
+                    index = k;
+                }
+            }
+            maxScore[j] = max;
+            maxIndex[j] = index;
+        }
+    }
 };
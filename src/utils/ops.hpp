@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <vector>
 #include <array>
+#include <cmath>
 
 #include "rknn_api.h"
 
@@ -18,6 +19,44 @@ namespace Utils
                          const std::vector<int>& classes,
                          float threshold);
 
+    /* 旋转框NMS的比较统计 */
+    struct RotatedNMSStats
+    {
+        uint64_t pairs {0};  // 比较的同类框对数
+        uint64_t exact {0};  // 未被外接矩形预判排除、需精确求交的框对数
+    };
+
+    /* 旋转框的4个顶点，依次为x0, y0, x1, y1 ... 按逆时针排列 */
+    void RotatedCorners(const RotatedRect& box, float* points);
+    float RotatedIoU(const RotatedRect& b1, const RotatedRect& b2);
+    /* 先以外接矩形交集估计IoU上界，上界不超过阈值的框对不做多边形求交 */
+    std::vector<int> RotatedNMS(const std::vector<RotatedRect>& boxes,
+                                const std::vector<float>& scores,
+                                const std::vector<int>& classes,
+                                float threshold,
+                                RotatedNMSStats* stats = nullptr);
+
+    /* 半精度分数张量上对连续n个网格并行求最高分类别，total为每个类别平面的元素数 */
+    void ArgmaxHalf(const Half* score, uint32_t total, uint32_t cls, uint32_t n, Half* maxScore, uint16_t* maxIndex);
+
+    /* 批量将SoA排布的检测框从模型输入坐标映射回原图坐标 */
+    void ToOriginal(const Transformation& trans, float* x, float* y, float* width, float* height, size_t n);
+
+    /* 批量裁剪BGR/RGB图像中的n个区域并双线性缩放，依次写入dst的n个连续批槽，直接输出减128后的int8，swapRB时交换R、B通道 */
+    void CropResize(const uint8_t* src, size_t stride, const Rect* rois, size_t n, int8_t* dst, const Size& size, bool swapRB);
+
+    /* 按量化参数生成256项sigmoid查找表，以量化值的低8位为下标 */
+    template<typename T>
+    void SigmoidTable(float scale, int32_t zp, std::array<float, 256>& table)
+    {
+        static_assert(sizeof(T) == 1, "sigmoid table only supports 8-bit tensors");
+        for (int i = 0; i < 256; i++) {
+            T q = static_cast<T>(i);
+            float v = (static_cast<float>(q) - zp) * scale;
+            table[static_cast<uint8_t>(q)] = 1.f / (1.f + std::exp(-v));
+        }
+    }
+
     template<typename T>
     void NC1HWC2ToNCHW(const T *src, T *dst, const rknn_tensor_attr* srcAttr, const rknn_tensor_attr* dstAttr)
     {
@@ -40,4 +79,28 @@ namespace Utils
             }
         }
     }
+
+    /* 按原始布局提取单个网格所有通道的值，避免整张量格式转换 */
+    template<typename T>
+    void GatherChannels(const T *src, T *dst, uint32_t cell, const rknn_tensor_attr* nativeAttr, const rknn_tensor_attr* attr)
+    {
+        uint32_t C = attr->dims[1];
+
+        if (nativeAttr->fmt == RKNN_TENSOR_NC1HWC2) {
+            uint32_t C2 = nativeAttr->dims[4];
+            uint32_t total = nativeAttr->dims[2] * nativeAttr->dims[3];
+            for (uint32_t c = 0; c < C; ++c) {
+                dst[c] = src[(c / C2) * total * C2 + cell * C2 + c % C2];
+            }
+        } else if (nativeAttr->fmt == RKNN_TENSOR_NHWC) {
+            for (uint32_t c = 0; c < C; ++c) {
+                dst[c] = src[cell * C + c];
+            }
+        } else {
+            uint32_t total = attr->dims[2] * attr->dims[3];
+            for (uint32_t c = 0; c < C; ++c) {
+                dst[c] = src[c * total + cell];
+            }
+        }
+    }
 };
@@ -0,0 +1,112 @@
+#include "overlay.hpp"
+
+#include <cstdio>
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+
+static inline uint32_t Pack(const Overlay::Color& c)
+{
+    return c.r | (c.g << 8) | (c.b << 16) | (static_cast<uint32_t>(c.a) << 24);
+}
+
+/* 填充矩形，坐标需已裁剪到缓冲区范围内 */
+static void Fill(uint8_t* rgba, int stride, int x0, int y0, int x1, int y1, uint32_t pixel)
+{
+    for (int y = y0; y < y1; y++) {
+        uint32_t* row = reinterpret_cast<uint32_t*>(rgba + y * stride);
+        std::fill(row + x0, row + x1, pixel);
+    }
+}
+
+
+Overlay::Overlay(double fontScale, int thickness, int padding) :
+_fontScale(fontScale), _thickness(thickness), _padding(padding)
+{
+
+}
+
+void Overlay::Draw(uint8_t* rgba, int width, int height, int stride, const std::vector<Item>& items)
+{
+    uint32_t text = Pack(_textColor);
+
+    for (auto &item : items) {
+        uint32_t color = Pack(item.color);
+        int x0 = std::clamp(item.box.x, 0, width);
+        int y0 = std::clamp(item.box.y, 0, height);
+        int x1 = std::clamp(item.box.x + item.box.width, 0, width);
+        int y1 = std::clamp(item.box.y + item.box.height, 0, height);
+        if (x0 >= x1 || y0 >= y1) {
+            continue;
+        }
+
+        /* 画框，只写四条边 */
+        int t = std::min({_thickness, x1 - x0, y1 - y0});
+        Fill(rgba, stride, x0, y0, x1, y0 + t, color);
+        Fill(rgba, stride, x0, y1 - t, x1, y1, color);
+        Fill(rgba, stride, x0, y0, x0 + t, y1, color);
+        Fill(rgba, stride, x1 - t, y0, x1, y1, color);
+
+        /* 文字，标签和分数分别缓存后拼接 */
+        char score[16];
+        std::snprintf(score, sizeof(score), " @ %.2f", item.score);
+        const Glyph &label = _Glyph(item.label);
+        const Glyph &value = _Glyph(score);
+        int textW = label.width + value.width + _padding * 2;
+        int textH = std::max(label.height, value.height) + _padding * 2;
+
+        /* 上方空间不足时画在框内 */
+        int tx0 = x0;
+        int ty0 = y0 - textH < 0 ? y0 : y0 - textH;
+        int tx1 = std::min(tx0 + textW, width);
+        int ty1 = std::min(ty0 + textH, height);
+        Fill(rgba, stride, tx0, ty0, tx1, ty1, color);
+
+        int gx = tx0 + _padding;
+        for (const Glyph* g : {&label, &value}) {
+            for (int y = 0; y < g->height && ty0 + _padding + y < ty1; y++) {
+                uint32_t* row = reinterpret_cast<uint32_t*>(rgba + (ty0 + _padding + y) * stride);
+                const uint8_t* a = &g->alpha[y * g->width];
+                for (int x = 0; x < g->width && gx + x < tx1; x++) {
+                    if (a[x] > 127) {
+                        row[gx + x] = text;
+                    }
+                }
+            }
+            gx += g->width;
+        }
+    }
+}
+
+size_t Overlay::GetCacheSize() const
+{
+    return _cache.size();
+}
+
+void Overlay::Clear()
+{
+    _cache.clear();
+}
+
+const Overlay::Glyph& Overlay::_Glyph(const std::string& text)
+{
+    auto it = _cache.find(text);
+    if (it != _cache.end()) {
+        return it->second;
+    }
+
+    /* 首次出现时栅格化 */
+    int baseline = 0;
+    auto size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, _fontScale, _thickness, &baseline);
+    Glyph glyph;
+    glyph.width = size.width;
+    glyph.height = size.height + baseline;
+    glyph.alpha.assign(glyph.width * glyph.height, 0);
+    if (glyph.width > 0 && glyph.height > 0) {
+        cv::Mat mask(glyph.height, glyph.width, CV_8UC1, glyph.alpha.data());
+        cv::putText(mask, text, {0, size.height}, cv::FONT_HERSHEY_SIMPLEX, _fontScale, {255}, _thickness);
+    }
+
+    return _cache.emplace(text, std::move(glyph)).first->second;
+}
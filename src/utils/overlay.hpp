@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "types.hpp"
+
+
+/* 检测结果叠加绘制，标签文字栅格化后缓存，直接绘制到RGBA显示缓冲区 */
+class Overlay
+{
+public:
+    struct Color
+    {
+        uint8_t r {0};
+        uint8_t g {0};
+        uint8_t b {0};
+        uint8_t a {255};
+    };
+
+    struct Item
+    {
+        Rect box;  // 显示缓冲区坐标
+        std::string label;
+        float score {0.f};
+        Color color {255, 0, 0, 255};
+    };
+
+    explicit Overlay(double fontScale = 1., int thickness = 2, int padding = 3);
+
+    /* stride为每行字节数，所有目标一次绘制完成 */
+    void Draw(uint8_t* rgba, int width, int height, int stride, const std::vector<Item>& items);
+    size_t GetCacheSize() const;
+    void Clear();
+
+private:
+    /* 文字的alpha遮罩 */
+    struct Glyph
+    {
+        int width {0};
+        int height {0};
+        std::vector<uint8_t> alpha;
+    };
+
+    double _fontScale;
+    int _thickness;
+    int _padding;
+    Color _textColor {255, 255, 255, 255};
+    std::unordered_map<std::string, Glyph> _cache;
+
+    const Glyph& _Glyph(const std::string& text);
+};
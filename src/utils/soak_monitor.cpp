@@ -0,0 +1,177 @@
+#include "soak_monitor.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <malloc.h>
+#include <unistd.h>
+
+
+SoakMonitor::SoakMonitor() :
+SoakMonitor(Config())
+{
+
+}
+
+SoakMonitor::SoakMonitor(const Config &config) :
+_config(config)
+{
+    _start = Clock::now();
+    _last = _start;
+}
+
+void SoakMonitor::Add(int64_t latency)
+{
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _calls++;
+    _window.Add(latency);
+    _total.Add(latency);
+    if (std::chrono::duration_cast<std::chrono::microseconds>(now - _last).count() >= _config.period) {
+        _Sample(now);
+    }
+}
+
+void SoakMonitor::Sample()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _Sample(Clock::now());
+}
+
+bool SoakMonitor::Failed() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_failure.empty();
+}
+
+std::string SoakMonitor::GetFailure() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _failure;
+}
+
+std::vector<SoakMonitor::Snapshot> SoakMonitor::GetSnapshots() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _samples;
+}
+
+void SoakMonitor::Dump() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::printf("soak: %lu calls, %ld samples\r\n", _calls, _samples.size());
+    for (size_t i = 0; i < _samples.size(); i++) {
+        const Snapshot &s = _samples[i];
+        std::printf("  %8.1f s%s calls: %lu, rss: %.1f MB, heap: %.1f MB, dmabuf: %d, fds: %d, p50: %ld us, p99: %ld us\r\n",
+                    s.time / 1e6,
+                    static_cast<int>(i) == _baseline ? " (baseline)" : "",
+                    s.calls,
+                    s.rss / 1048576.,
+                    s.heap / 1048576.,
+                    s.dmabuf,
+                    s.fds,
+                    s.p50,
+                    s.p99);
+    }
+    _total.Dump("  latency");
+    std::printf("soak %s%s\r\n", _failure.empty() ? "passed" : "failed: ", _failure.c_str());
+}
+
+int64_t SoakMonitor::ReadRss()
+{
+    /* 第二项为常驻页数 */
+    std::ifstream ifs("/proc/self/statm");
+    int64_t size = 0, resident = 0;
+    if (!(ifs >> size >> resident)) {
+        return -1;
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+int64_t SoakMonitor::ReadHeap()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+#else
+    struct mallinfo info = mallinfo();
+#endif
+    return static_cast<int64_t>(info.uordblks) + static_cast<int64_t>(info.hblkhd);
+}
+
+int SoakMonitor::CountFds(int* dmabuf)
+{
+    /* DMA-buf的链接目标为 "/dmabuf:" 或 "anon_inode:dmabuf"，取决于内核版本 */
+    int fds = 0;
+    int bufs = 0;
+    std::error_code ec;
+    for (auto &entry : std::filesystem::directory_iterator("/proc/self/fd", ec)) {
+        fds++;
+        std::string target = std::filesystem::read_symlink(entry.path(), ec).string();
+        if (target.find("dmabuf") != std::string::npos) {
+            bufs++;
+        }
+    }
+    if (dmabuf) {
+        *dmabuf = bufs;
+    }
+    return fds;
+}
+
+void SoakMonitor::_Sample(Clock::time_point now)
+{
+    Snapshot s;
+    s.time = std::chrono::duration_cast<std::chrono::microseconds>(now - _start).count();
+    s.calls = _calls;
+    s.rss = ReadRss();
+    s.heap = ReadHeap();
+    s.fds = CountFds(&s.dmabuf);
+    s.p50 = _window.Percentile(50.);
+    s.p99 = _window.Percentile(99.);
+    _samples.push_back(s);
+    _window.Reset();
+    _last = now;
+
+    /* 预热结束后首个有调用的窗口作为基线 */
+    if (_baseline < 0) {
+        if (s.time >= _config.warmup && s.calls > 0) {
+            _baseline = static_cast<int>(_samples.size()) - 1;
+        }
+        return;
+    }
+    _Check(s);
+}
+
+void SoakMonitor::_Check(const Snapshot &s)
+{
+    if (!_failure.empty()) {
+        return;
+    }
+
+    const Snapshot &base = _samples[_baseline];
+    char reason[256] = {0};
+    auto over = [&](int &count, bool exceeded, const char* what) {
+        count = exceeded ? count + 1 : 0;
+        if (count >= _config.confirm && reason[0] == 0) {
+            std::snprintf(reason, sizeof(reason), "%s at %.1f s", what, s.time / 1e6);
+        }
+    };
+
+    over(_rssOver, s.rss - base.rss > _config.rssGrowth, "rss growth");
+    over(_heapOver, s.heap - base.heap > _config.heapGrowth, "heap growth");
+    over(_dmabufOver, s.dmabuf - base.dmabuf > _config.dmabufGrowth, "dmabuf growth");
+    over(_fdOver, s.fds - base.fds > _config.fdGrowth, "fd growth");
+    over(_p99Over, base.p99 > 0 && s.p99 > base.p99 * (1.0 + _config.p99Drift), "p99 drift");
+
+    if (reason[0] != 0) {
+        char detail[256];
+        std::snprintf(detail, sizeof(detail), ", rss %+.1f MB, heap %+.1f MB, dmabuf %+d, fds %+d, p99 %ld -> %ld us",
+                      (s.rss - base.rss) / 1048576.,
+                      (s.heap - base.heap) / 1048576.,
+                      s.dmabuf - base.dmabuf,
+                      s.fds - base.fds,
+                      base.p99,
+                      s.p99);
+        _failure = std::string(reason) + detail;
+        std::printf("soak failed: %s\r\n", _failure.c_str());
+    }
+}
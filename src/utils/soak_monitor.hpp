@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+#include "histogram.hpp"
+
+
+/* 长时间运行的内存增长及延迟漂移检测，周期采样RSS、堆占用、打开的DMA-buf数及窗口p99延迟 */
+/* 预热结束后的首次采样作为基线，连续若干次采样超出界限即判定失败 */
+class SoakMonitor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config
+    {
+        int64_t period {10000000};  // 采样周期(us)
+        int64_t warmup {30000000};  // 预热时长(us)，期间的内存增长及延迟不计入
+        int64_t rssGrowth {16 << 20};  // 相对基线允许的RSS增长(字节)
+        int64_t heapGrowth {8 << 20};  // 相对基线允许的堆占用增长(字节)
+        int dmabufGrowth {0};  // 相对基线允许增加的DMA-buf数
+        int fdGrowth {4};  // 相对基线允许增加的文件描述符数
+        float p99Drift {0.5f};  // 窗口p99相对基线窗口允许增加的比例
+        int confirm {3};  // 连续超出界限的采样次数达到该值才判定失败，过滤瞬时抖动
+    };
+
+    struct Snapshot
+    {
+        int64_t time {0};  // 距启动的时间(us)
+        uint64_t calls {0};  // 累计调用次数
+        int64_t rss {0};  // 常驻内存(字节)
+        int64_t heap {0};  // 堆已分配(字节)，含mmap分配的大块
+        int dmabuf {0};  // 打开的DMA-buf数
+        int fds {0};  // 打开的文件描述符数
+        int64_t p50 {0};  // 本窗口延迟中位数(us)
+        int64_t p99 {0};  // 本窗口p99延迟(us)
+    };
+
+    SoakMonitor();
+    explicit SoakMonitor(const Config &config);
+
+    /* 每次调用后记录延迟，到达采样周期时顺带采样及检查 */
+    void Add(int64_t latency);
+    void Sample();
+
+    bool Failed() const;
+    std::string GetFailure() const;
+    std::vector<Snapshot> GetSnapshots() const;
+    void Dump() const;
+
+    static int64_t ReadRss();
+    static int64_t ReadHeap();
+    static int CountFds(int* dmabuf);
+
+private:
+    Config _config;
+    mutable std::mutex _mutex;
+    Clock::time_point _start;
+    Clock::time_point _last;
+    uint64_t _calls {0};
+    Histogram _window;
+    Histogram _total;
+    std::vector<Snapshot> _samples;
+    int _baseline {-1};  // 基线采样下标，预热结束前为-1
+    int _rssOver {0};  // 各指标连续超出界限的次数
+    int _heapOver {0};
+    int _dmabufOver {0};
+    int _fdOver {0};
+    int _p99Over {0};
+    std::string _failure;
+
+    void _Sample(Clock::time_point now);
+    void _Check(const Snapshot &s);
+};
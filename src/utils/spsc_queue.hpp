@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+/* 单生产者单消费者无锁环形队列 */
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) : _buffer(capacity + 1) {}
+
+    bool Push(const T& value)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) % _buffer.size();
+        if (next == _head.load(std::memory_order_acquire)) {
+            return false;  // 队列满
+        }
+        _buffer[tail] = value;
+        _tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& value)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;  // 队列空
+        }
+        value = _buffer[head];
+        _head.store((head + 1) % _buffer.size(), std::memory_order_release);
+        return true;
+    }
+
+    size_t Size() const
+    {
+        size_t head = _head.load(std::memory_order_acquire);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        return (tail + _buffer.size() - head) % _buffer.size();
+    }
+
+private:
+    std::vector<T> _buffer;
+    alignas(64) std::atomic<size_t> _head {0};
+    alignas(64) std::atomic<size_t> _tail {0};
+};